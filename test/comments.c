@@ -0,0 +1,11 @@
+int a; // see /* here
+#include "include2.h"
+/* */
+int b; /* a // in a block comment
+is not a line comment */
+#include "include.h"
+// a spliced line comment \
+#include "missing.h"
+int main() {
+	return a + b;
+}
@@ -0,0 +1,9 @@
+target triple = "x86_64-apple-macosx10.9.0"
+%a = alloca i64
+%OWN_PI = alloca double
+%b = alloca i64
+%GLOBAL = alloca i64
+%OWN_PI = alloca double
+
+;Function Attrs: 
+define 
\ No newline at end of file
@@ -0,0 +1,19 @@
+# define X 1
+int a = X;
+#  if 0
+int no;
+  #  endif
+# ifdef X
+int yes;
+# else
+int no;
+# endif
+#if 0
+# if 1
+int no;
+# endif
+int no;
+#endif
+int main() {
+	return a + yes;
+}
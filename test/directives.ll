@@ -0,0 +1,6 @@
+target triple = "x86_64-apple-macosx10.9.0"
+%a = alloca i64
+%yes = alloca i64
+
+;Function Attrs: 
+define 
\ No newline at end of file
@@ -0,0 +1,18 @@
+target triple = "x86_64-apple-macosx10.9.0"
+%a = alloca i64
+%sum = alloca double
+%mult = alloca i64
+
+;Function Attrs: 
+define i64 @function(i64 %__arg_1) {
+%a = alloca i64
+store i64 %__arg_1, i64* %a
+%b = alloca i64
+store i64 3, i64* %b
+%1 = load i64* %a
+%2 = load i64* %b
+%3 = add i64 %1, %2
+store i64 %3, i64* %c
+%4 = load i64* %c
+ret i64 %4
+}
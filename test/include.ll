@@ -0,0 +1,7 @@
+target triple = "x86_64-apple-macosx10.9.0"
+%chars = alloca i8
+%GLOBAL = alloca i64
+%OWN_PI = alloca double
+
+;Function Attrs: 
+define 
\ No newline at end of file
@@ -0,0 +1,124 @@
+target triple = "x86_64-apple-macosx10.9.0"
+
+
+
+
+;Function Attrs: 
+define i64 @main() {
+%temp = alloca i64
+store i64 4, i64* %temp
+%1 = load i64* %temp
+%2 = call i64 @func(i64 %1, i64 16)
+store i64 %2, i64* %temp
+%3 = load i64* %temp
+
+%4 = call i64 @square(i64 8)
+%5 = add i64 %3, %4
+store i64 %5, i64* %temp
+
+%6 = call i64 @func2(i64 16)
+store i64 %6, i64* %temp
+%7 = load i64* %temp
+ret i64 %7
+}
+
+
+;Function Attrs: 
+define i64 @func2(i64 %__arg_1) {
+%limit = alloca i64
+store i64 %__arg_1, i64* %limit
+%i = alloca i64
+store i64 0, i64* %i
+br label %1
+%2 = load i64* %i
+%3 = add i64 %2, 1
+store i64 %3, i64* %i
+%4 = load i64* %i
+%5 = load i64* %limit
+%6 = icmp slt i64 %4, %5
+%7 = icmp eq i1 %6, 0
+br i1 %7, label %8, label %1
+
+store i64 0, i64* %i
+%9 = load i64* %i
+%10 = load i64* %limit
+%11 = mul i64 2, %10
+%12 = icmp slt i64 %9, %11
+%13 = icmp ne i1 %12, 0
+br i1 %13, label %14, label %23
+br label %15
+%16 = load i64* %i
+%17 = add i64 %16, 1
+store i64 %17, i64* %i
+%18 = load i64* %i
+%19 = load i64* %limit
+%20 = mul i64 2, %19
+%21 = icmp slt i64 %18, %20
+%22 = icmp eq i1 %21, 0
+br i1 %22, label %23, label %15
+%24 = load i64* %i
+ret i64 %24
+}
+
+
+;Function Attrs: 
+define i64 @func(i64 %__arg_1, i64 %__arg_2) {
+%a = alloca i64
+store i64 %__arg_1, i64* %a
+
+%c = alloca i64
+store i64 %__arg_2, i64* %c
+%b = alloca i64
+store i64 3, i64* %b
+%1 = load i64* %b
+%2 = load i64* %c
+%3 = add i64 %1, %2
+store i64 %3, i64* %a
+
+%4 = icmp eq i64 0, 1
+br i1 %4, label %5, label %14
+%6 = load i64* %a
+%7 = load i64* %a
+%8 = add i64 %6, %7
+store i64 %8, i64* %a
+%9 = load i64* %a
+%10 = load i64* %a
+%11 = add i64 %9, %10
+store i64 %11, i64* %a
+%12 = load i64* %b
+ret i64 %12
+br label %24
+%15 = load i64* %b
+%16 = load i64* %b
+%17 = add i64 %15, %16
+store i64 %17, i64* %b
+%18 = load i64* %b
+%19 = load i64* %b
+%20 = mul i64 %18, %19
+%21 = load i64* %b
+%22 = mul i64 %20, %21
+ret i64 %22
+br label %24
+%da = alloca double
+%db = alloca double
+%dc = alloca double
+store double 13.0, double* %da
+store double 17.5, double* %db
+%25 = load double* %da
+%26 = load double* %db
+%27 = fdiv double %25, %26
+store double %27, double* %dc
+%28 = load i64* %c
+ret i64 %28
+}
+
+
+;Function Attrs: 
+define i64 @square(i64 %__arg_1) {
+%a = alloca i64
+store i64 %__arg_1, i64* %a
+%1 = load i64* %a
+%2 = load i64* %a
+%3 = mul i64 %1, %2
+ret i64 %3
+}
@@ -0,0 +1,13 @@
+typedef int T;
+typedef long* P;
+struct S {
+	T member;
+	P next;
+};
+int f(T a) {
+	T x;
+	P y = 0;
+	const T z = 1;
+	x = a + z;
+	return x;
+}
@@ -3,6 +3,7 @@
 #include <list>
 #include <ostream>
 #include "source.h"
+#include "arena.h"
 using namespace std;
 
 template<class T>
@@ -61,6 +62,9 @@ class TypeList;
 class Node {
 	public:
 		Node() {}
+		//Nodes live in the NodeArena until the translation unit is done
+		static void* operator new(size_t size) {return NodeArena::allocate(size);}
+		static void operator delete(void*) {}
 		virtual string getName() = 0; //Returns string representation of object
 		virtual Type* getType(Scope* s);
 		virtual bool typeCheck(Scope* s);
@@ -75,40 +79,36 @@ class Node {
 };
 
 //A template class to handle repeating occurences of some class
-/* Implemened as a singly linked list
+/* The items are kept in order in one vector in the arena. Lists such as the
+ * external declarations of a translation unit can be very long, so they are
+ * built and walked with loops, never recursion as deep as the list.
  */
 template<class T>
 class NodeList : public Node {
 	public:
-		NodeList(T* item) : item(item), next(NULL) {}
-		NodeList(T* item, NodeList* next) : item(item), \
-															  next(next) {}
-		NodeList(T* item, NodeList* next, string delimiter) \
-		: item(item), next(next), delimiter(delimiter) {}	
-		virtual string getName() {
-			string ret = item->getName();
-			if (next != NULL) {
-				ret += '\n' + next->getName();
-			}
-			return ret;
-		}
+		typedef vector<T*, ArenaAllocator<T*> > Items;
+		NodeList(T* item) : items(1, item) {}
+		NodeList(T* item, string delimiter) : items(1, item), \
+			delimiter(delimiter) {}
+		virtual string getName() {return this->join("\n");}
 		virtual ~NodeList() {
-			if (next != NULL) {delete next;}
-			delete item;
+			for (T* item : this->items) {
+				delete item;
+			}
 		}
-		void setNext(NodeList* n) {next = n;}
-		virtual Type* getType(Scope* s) {return item->getType(s);}	
+		void add(T* item) {this->items.push_back(item);} //At the end
+		virtual Type* getType(Scope* s) {return this->items[0]->getType(s);}
 		virtual TypeList* getTypes(Scope* s);
 		virtual bool typeCheck(Scope* scope);
 		virtual string genLLVM(Scope* s, Consumer<string>* output);
-		T* getItem() {return item;}
-		NodeList* getNext() {return next;}
-		void getNames(Scope* s, list<string>* ret);
+		T* getItem() {return this->items[0];}
+		const Items& getItems() const {return this->items;}
+		size_t size() const {return this->items.size();}
 		string getLLVMName() const;
 	protected:
-		bool typeCheck(Scope* s, Type* t);
-		T* item;
-		NodeList* next = NULL; //Optional, might be NULL
+		//The names of the items with separator between them
+		string join(const string& separator) const;
+		Items items; //Never empty, an item might be NULL
 		string delimiter = "\n";
 };
 
@@ -142,21 +142,21 @@ enum BasicTypeEnum {_BOOL, CHAR, SIGNED_CHAR, UNSIGNED_CHAR, SHORT_INT, \
 		LONG_LONG_INT,  UNSIGNED_LONG_LONG_INT, FLOAT, DOUBLE, LONG_DOUBLE};
 enum TypeKindEnum {NO_TYPE, BASIC, FUNCTION, POINTER, STRUCT, UNION};
 
+//! A type of C, of which there is one of each, made by TypeContext
+/*! Two types are the same exactly when they are the same object, so types
+ * are compared as pointers.
+ */
 class Type {
 	public:
 		Type(TypeKindEnum kind, unsigned int size) : kind(kind), size(size) {}
+		static void* operator new(size_t size) {return NodeArena::allocate(size);}
+		static void operator delete(void*) {}
 		virtual unsigned int getSize() {return this->size;}
 		TypeKindEnum getKind() const {return this->kind;}
 		virtual string getName() const = 0;
 		virtual string getLLVMName() const = 0;
-		virtual bool operator ==(const Type& other) const {
-			return this->equals(other);
-		}
-		virtual bool equals(const Type& other) const = 0;
-		bool operator !=(const Type& other) const {
-			return !(*this == other);
-		}
-		virtual ~Type() {}
+	protected:
+		virtual ~Type() {} //Types are shared, so none is ever deleted
 	private:
 		TypeKindEnum kind;
 		unsigned int size = 0; //In bytes
@@ -164,37 +164,20 @@ class Type {
 
 class NoType: public Type {
 	public:
-		NoType() : Type(NO_TYPE, 0) {}
-		bool equals(const Type& other) const {
-			//There is only one NO_TYPE, so true if kind matches
-			return this->getKind() == other.getKind();
-		}
 		string getName() const {
 			return "NO TYPE";
 		}
 		string getLLVMName() const {
 			return "void";
 		}
+	private:
+		NoType() : Type(NO_TYPE, 0) {}
+		friend class TypeContext;
 };
 
 class BasicType : public Type {
 	public:
-		BasicType(BasicTypeEnum basicType) : \
-			Type(BASIC, this->getSize(basicType)), basicType(basicType) {}
 		BasicTypeEnum getBasicType() const {return this->basicType;}
-		virtual bool equals(const Type& other) const {
-			//Try to downcast other to BasicType
-			if (const BasicType* otherDown = \
-					dynamic_cast<const BasicType*>(&other)) {
-				//Ah, they are both basic types!
-				//Compare the BasicTypeEnum values
-				if (this->getBasicType() == otherDown->getBasicType()) {
-					return true;
-				}
-			}
-			//If failed, return false
-			return false;
-		}
 		static unsigned int getSize(BasicTypeEnum basicType) {
 			switch(basicType) {
 				case _BOOL : return 1;
@@ -254,28 +237,20 @@ class BasicType : public Type {
 			}
 		}
 	private:
+		BasicType(BasicTypeEnum basicType) : \
+			Type(BASIC, this->getSize(basicType)), basicType(basicType) {}
+		friend class TypeContext;
 		BasicTypeEnum basicType;
 };
 
 class PointerType : public Type {
 	public:
-		PointerType(Type* pointeeType) : Type(POINTER, 8), \
-										 pointeeType(pointeeType) {}
-		virtual bool equals(const Type& other) const {
-			//Try to downcast
-			if (const PointerType* otherDown = \
-					dynamic_cast<const PointerType*>(&other)) {
-				return pointeeType->equals(*otherDown);
-			}
-			return false;
-		}
 		string getName() const {
 			string ret = "*";
 			if (pointeeType != NULL) {ret += pointeeType->getName();}
 			return ret;
 		}
 		Type* getPointeeType() {return pointeeType;}
-		virtual ~PointerType() {if (pointeeType != NULL) {delete pointeeType;}}
 		string getLLVMName() const {
 			if (pointeeType != NULL) {
 				return pointeeType->getLLVMName() + " *";
@@ -284,27 +259,19 @@ class PointerType : public Type {
 			}
 		}
 	private:
+		PointerType(Type* pointeeType) : Type(POINTER, 8), \
+										 pointeeType(pointeeType) {}
+		friend class TypeContext;
 		Type* pointeeType = NULL;
 };
 
+//! Types in order, made by TypeContext like the types themselves
 class TypeList {
 	public:
-		TypeList(Type* item, TypeList* next) : item(item), next(next) {}
-		TypeList(Type* item) : item(item), next(NULL) {}
+		static void* operator new(size_t size) {return NodeArena::allocate(size);}
+		static void operator delete(void*) {}
 		Type* getItem() const {return this->item;}
 		TypeList* getNext() const {return this->next;}
-		virtual bool equals(const TypeList& other) const {
-			if (this->getNext() == NULL && \
-					other.getNext() == NULL) {
-				return item->equals(*other.getItem());
-			} else if (this->getNext() == NULL || \
-					other.getNext() == NULL) {
-				return false;
-			} else {
-				return item->equals(*other.getItem()) && \
-					next->equals(*other.getNext());
-			}
-		}
 		unsigned int getStructSize() {
 			//This should only be used on the first element in the list
 			return this->getStructSize(0);
@@ -325,11 +292,10 @@ class TypeList {
 			if (next != NULL) {ret += next->getLLVMName();}
 			return ret;
 		}
-		virtual ~TypeList() {
-			if (item != NULL) {delete item;}
-			if (next != NULL) {delete next;}
-		}
 	protected:
+		TypeList(Type* item, TypeList* next) : item(item), next(next) {}
+		~TypeList() {}
+		friend class TypeContext;
 		unsigned int getStructSize(unsigned int current) {
 			unsigned int itemSize = item->getSize();
 			if (next == NULL) {
@@ -360,21 +326,6 @@ class TypeList {
 
 class FunctionType : public Type {
 	public:
-		FunctionType(Type* returnType, TypeList* params) : Type(FUNCTION, 8), \
-   returnType(returnType), params(params) {}
-		virtual bool equalsSubType(const FunctionType& other) const {
-			return returnType->equals(*other.getReturnType()) && \
-				params->equals(*other.getParams());
-		}
-		virtual bool equals(const Type& other) const {
-			//Try to downcast
-			if (const FunctionType* otherDown = \
-					dynamic_cast<const FunctionType*>(&other)) {
-				return this->equalsSubType(*otherDown);
-			} else {
-				return false;
-			}
-		}
 		string getName() const {
 			string ret = "";
 			if (returnType != NULL) {ret += returnType->getName();}
@@ -385,10 +336,6 @@ class FunctionType : public Type {
 		}
 		Type* getReturnType() const {return this->returnType;}
 		TypeList* getParams() const {return this->params;}
-		virtual ~FunctionType() {
-			if (returnType != NULL) {delete returnType;}
-			if (params != NULL) {delete params;}
-		}
 		string getLLVMName() const {
 			string ret = "";
 			if (returnType != NULL) {
@@ -404,23 +351,16 @@ class FunctionType : public Type {
 			return ret;
 		}
 	private:
+		FunctionType(Type* returnType, TypeList* params) : Type(FUNCTION, 8), \
+   returnType(returnType), params(params) {}
+		friend class TypeContext;
 		Type* returnType = NULL;
 		TypeList* params = NULL;
 };
 
 class StructType : public Type {
 	public:
-		StructType(TypeList* members) : Type(STRUCT, members->getStructSize()), \
-										members(members) {}
 		TypeList* getMembers() const {return this->members;}
-		virtual bool equals(const Type& other) const {
-			if (const StructType* otherDown = \
-					dynamic_cast<const StructType*>(&other)) {
-				return members->equals(*otherDown->getMembers());
-			} else {
-				return false;
-			}
-		}
 		string getName() const {
 			string ret = "struct {";
 			if (members != NULL) {ret += members->getName();}
@@ -433,26 +373,16 @@ class StructType : public Type {
 			ret += "}";
 			return ret;
 		}
-		virtual ~StructType() {
-			if (members != NULL) {delete members;}
-		}
 	private:
+		StructType(TypeList* members) : Type(STRUCT, members->getStructSize()), \
+										members(members) {}
+		friend class TypeContext;
 		TypeList* members = NULL;
 };
 
 class UnionType : public Type {
 	public:
-		UnionType(TypeList* members) : Type(STRUCT, members->getUnionSize()), \
-									   members(members) {}
 		TypeList* getMembers() const {return this->members;}
-		virtual bool equals(const Type& other) const {
-			if (const UnionType* otherDown = \
-					dynamic_cast<const UnionType*>(&other)) {
-				return members->equals(*otherDown->getMembers());
-			} else {
-				return false;
-			}
-		}
 		string getName() const {
 			string ret = "union {";
 			if (members != NULL) {ret += members->getName();}
@@ -466,25 +396,56 @@ class UnionType : public Type {
 			ret += "}";
 			return ret;
 		}
-		virtual ~UnionType() {
-			if (members != NULL) {delete members;}
-		}
 	private:
+		UnionType(TypeList* members) : Type(STRUCT, members->getUnionSize()), \
+									   members(members) {}
+		friend class TypeContext;
 		TypeList* members = NULL;
 };
 
+//! The table of the types of a translation unit, which makes each type once
+/*! A type is made of types which are in the table already, so looking it up
+ * only compares pointers, and asking for a type again returns the one made
+ * the first time. Types are allocated in the NodeArena and the table has to
+ * be released together with it.
+ */
+class TypeContext {
+	public:
+		static NoType* getNoType();
+		static BasicType* getBasicType(BasicTypeEnum basicType);
+		static PointerType* getPointerType(Type* pointeeType);
+		//The list of item followed by next, which may be NULL
+		static TypeList* getTypeList(Type* item, TypeList* next = NULL);
+		static FunctionType* getFunctionType(Type* returnType, TypeList* params);
+		static StructType* getStructType(TypeList* members);
+		static UnionType* getUnionType(TypeList* members);
+		static void release(); //Forgets all types, before NodeArena::release()
+		static size_t getMade() {return instance().made;} //Types and lists
+		static size_t getLookups() {return instance().lookups;}
+	private:
+		TypeContext() : made(0), lookups(0) {this->clear();}
+		static TypeContext& instance();
+		void clear();
+		NoType* noType;
+		BasicType* basicTypes[LONG_DOUBLE + 1];
+		map<const Type*, PointerType*> pointerTypes; //By pointee
+		map<pair<const Type*, const TypeList*>, TypeList*> typeLists;
+		map<pair<const Type*, const TypeList*>, FunctionType*> functionTypes;
+		map<const TypeList*, StructType*> structTypes; //By members
+		map<const TypeList*, UnionType*> unionTypes;
+		size_t made;
+		size_t lookups;
+};
+
 //Represents one entry in a symbol table
 class Symbol {
 	public:
 		Symbol(Type* type) : type(type) {}
 		Type* getType() {
 			if (type != NULL) return type;
-			type = new NoType();
+			type = TypeContext::getNoType();
 			return type;
 		}
-		~Symbol() {
-			if (type != NULL) {delete type;}
-		}
 	private:
 		Type* type = NULL;
 };
@@ -492,8 +453,12 @@ class Symbol {
 class SymbolTable {
 	public:
 		SymbolTable() {}
-		Symbol* find(const string input) {
-			auto search = mVarType.find(input);
+		Symbol* find(const string& input) {
+			unsigned int symbol;
+			if (!Interner::find(input, symbol)) {
+				return NULL; //Never interned, so never inserted
+			}
+			auto search = mVarType.find(symbol);
 			if (search != mVarType.end()) {
 				return search->second;
 			} else {
@@ -504,20 +469,20 @@ class SymbolTable {
 			if (this->find(key) != NULL) {
 				return false; //Already in the list, can't insert
 			} else {
-				mVarType[key] = new Symbol(val);
+				mVarType[Interner::intern(key)] = new Symbol(val);
 				return true;
 			}
 		}
 		bool remove(string key) {
 			if (this->find(key) != NULL) {
-				mVarType.erase(key);
+				mVarType.erase(Interner::intern(key));
 				return true;
 			} else {
 				return false; //Not found, can't delete
 			}
 		}
 	private:
-		map<string, Symbol*> mVarType;
+		map<unsigned int, Symbol*> mVarType; //Keyed by interned name
 };
 
 class Scope {
@@ -576,35 +541,33 @@ class TypeError : public runtime_error {
 
 template<class T>
 bool NodeList<T> :: typeCheck(Scope* s) {
-	if (next == NULL && item == NULL) {
-		return true;
-	} else if (next == NULL && item != NULL) {
-		return item->typeCheck(s);
-	} else if (next != NULL && item == NULL) {
-		//Should not happen very much
-		return next->typeCheck(s, item->getType(s));
-	} else {
-		return item->typeCheck(s) && next->typeCheck(s, item->getType(s));
+	//Every item must have the type of the first one
+	T* first = this->items[0];
+	if (first == NULL) {
+		return this->items.size() == 1;
 	}
-}
-
-template<class T>
-bool NodeList<T> :: typeCheck(Scope* s, Type* t) {
-	if (next == NULL) {
-		return item->typeCheck(s) && *t == *item->getType(s);
-	} else {
-		return item->typeCheck(s) && *t == *item->getType(s) && next->typeCheck(s, t);
+	if (!first->typeCheck(s)) {
+		return false;
+	}
+	Type* t = first->getType(s);
+	for (size_t k = 1; k < this->items.size(); ++k) {
+		T* item = this->items[k];
+		if (!item->typeCheck(s) || t != item->getType(s)) {
+			return false;
+		}
 	}
+	return true;
 }
 
 template<class T>
 string NodeList<T> :: genLLVM(Scope* s, Consumer<string>* o) {
-	if (item != NULL) {
-		item->genLLVM(s, o);
-	}
-	if (next != NULL) {
-		o->put(this->delimiter);
-		next->genLLVM(s, o);
+	for (size_t k = 0; k < this->items.size(); ++k) {
+		if (k > 0) {
+			o->put(this->delimiter);
+		}
+		if (this->items[k] != NULL) {
+			this->items[k]->genLLVM(s, o);
+		}
 	}
 	return "";
 }
@@ -612,19 +575,38 @@ string NodeList<T> :: genLLVM(Scope* s, Consumer<string>* o) {
 template<class T>
 string NodeList<T> :: getLLVMName() const {
 	string ret = "";
-	if (item != NULL) {ret += item->getLLVMName();}
-	if (next != NULL) {ret += ", " + next->getLLVMName();}
+	for (size_t k = 0; k < this->items.size(); ++k) {
+		if (k > 0) {ret += ", ";}
+		if (this->items[k] != NULL) {ret += this->items[k]->getLLVMName();}
+	}
+	return ret;
+}
+
+template<class T>
+string NodeList<T> :: join(const string& separator) const {
+	string ret = "";
+	for (size_t k = 0; k < this->items.size(); ++k) {
+		if (k > 0) {ret += separator;}
+		if (this->items[k] != NULL) {ret += this->items[k]->getName();}
+	}
 	return ret;
 }
 
+//The types are linked up from the last one, a NULL item ends the list
 template<class T>
 TypeList* NodeList<T> :: getTypes(Scope* s) {
-	if (next != NULL && item != NULL) {
-		return new TypeList(item->getType(s), next->getTypes(s));
-	} else if (item != NULL) {
-		return new TypeList(item->getType(s));
-	} else {
-		return new TypeList(new NoType());
+	vector<Type*> types;
+	for (T* item : this->items) {
+		if (item == NULL) {
+			types.push_back(TypeContext::getNoType());
+			break;
+		}
+		types.push_back(item->getType(s));
 	}
+	TypeList* ret = NULL;
+	for (size_t k = types.size(); k > 0; --k) {
+		ret = TypeContext::getTypeList(types[k - 1], ret);
+	}
+	return ret;
 }
 
@@ -0,0 +1,35 @@
+#include "arena.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+void* NodeArena :: grow(size_t size) {
+	//Every allocation after release() gets here, as nothing is left
+	assert(!this->released);
+	//What is left of the current chunk is kept for smaller nodes if the node
+	//is a large one, which gets a block of its own
+	size_t length = size > chunkSize / 4 ? size : chunkSize;
+	char* block = (char*) malloc(length);
+	if (block == NULL) {
+		throw bad_alloc();
+	}
+	this->blocks.push_back(block);
+	++this->chunks;
+	if (length == chunkSize) {
+		this->next = block + size;
+		this->left = chunkSize - size;
+	}
+	return block;
+}
+
+void NodeArena :: release() {
+	NodeArena& arena = instance();
+	assert(!arena.released);
+	arena.released = true;
+	for (char* block : arena.blocks) {
+		free(block);
+	}
+	arena.blocks.clear();
+	arena.next = NULL;
+	arena.left = 0;
+}
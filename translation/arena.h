@@ -0,0 +1,71 @@
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+//! A bump-pointer arena which all Nodes and Types of the AST are allocated in
+/*! Nodes are carved out of large chunks in the order they are made, so a
+ * node usually sits next to its children. Deleting a node runs its
+ * destructor but gives no memory back. All of it is freed at once by
+ * release() without running any destructors, so what the nodes own outside
+ * the arena, e.g. the characters of long strings, is never freed. That is
+ * only fine because a process translates one unit and releases the arena
+ * when it is done with it, just before it exits. Nothing may be allocated
+ * after that, see grow().
+ */
+class NodeArena {
+	public:
+		static void* allocate(size_t size) {
+			NodeArena& arena = instance();
+			size = (size + alignment - 1) & ~(alignment - 1);
+			arena.bytes += size;
+			if (size > arena.left) {
+				return arena.grow(size);
+			}
+			void* at = arena.next;
+			arena.next += size;
+			arena.left -= size;
+			return at;
+		}
+		//Frees every chunk, once, when the process is done with the AST
+		static void release();
+		static size_t getBytes() {return instance().bytes;} //Allocated in total
+		static size_t getChunks() {return instance().chunks;}
+	private:
+		NodeArena() : next(NULL), left(0), bytes(0), chunks(0), \
+			released(false) {}
+		static NodeArena& instance() {
+			static NodeArena arena;
+			return arena;
+		}
+		void* grow(size_t size); //Allocates from a new chunk
+		static const size_t alignment = alignof(max_align_t);
+		static const size_t chunkSize = 1 << 16;
+		vector<char*> blocks; //Chunks, and allocations too large for one
+		char* next; //Where the next node goes in the current chunk
+		size_t left; //Bytes left in the current chunk
+		size_t bytes;
+		size_t chunks;
+		bool released;
+};
+
+//! Allocates the storage of containers which belong to the AST in the arena
+/*! Storage is never given back, as with nodes, so a vector which grows
+ * leaves its old storage behind until release(). It is at most as large as
+ * what the vector ends up with.
+ */
+template<class T>
+class ArenaAllocator {
+	public:
+		typedef T value_type;
+		ArenaAllocator() {}
+		template<class U>
+		ArenaAllocator(const ArenaAllocator<U>&) {}
+		T* allocate(size_t n) {
+			return (T*) NodeArena::allocate(n * sizeof(T));
+		}
+		void deallocate(T*, size_t) {}
+		template<class U>
+		bool operator==(const ArenaAllocator<U>&) const {return true;}
+		template<class U>
+		bool operator!=(const ArenaAllocator<U>&) const {return false;}
+};
@@ -0,0 +1,69 @@
+#!/bin/sh
+# Compares the tokens per second of the Lexer at two revisions, over the
+# files in test/ repeated COPIES times (2000 by default).
+#
+#   bench/lexer.sh [OLD [NEW]]
+#
+# OLD is by default the three-pass Lexer, i.e. the parent of the first
+# commit tagged [user-005]. NEW is the working tree, also given as '.'.
+# Only the objects the Lexer is in or uses are built, and sections nothing
+# reaches from bench/lexer.cpp are left out when linking, so the parser and
+# code generation need not build.
+set -e
+here=$(cd "$(dirname "$0")/.." && pwd)
+top=$(git -C "$here" rev-parse --show-toplevel)
+prefix=$(git -C "$here" rev-parse --show-prefix)
+if [ $# -ge 1 ]; then
+	old=$1
+else
+	old=$(git -C "$top" log --format=%H --grep='^\[user-005\] ' | tail -n 1)
+	if [ -z "$old" ]; then
+		echo "No commit tagged [user-005], give the old revision" >&2
+		exit 1
+	fi
+	old="$old^"
+fi
+new=${2:-.}
+copies=${COPIES:-2000}
+# Older revisions only build with -fpermissive
+flags="-std=c++11 -O2 -pthread -fpermissive -w -ffunction-sections \
+	-fdata-sections"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+i=0
+while [ $i -lt "$copies" ]; do
+	cat "$here"/../test/*.c
+	i=$((i + 1))
+done > "$work/corpus.c"
+
+# build REVISION DIRECTORY
+build() {
+	mkdir -p "$2/bench"
+	if [ "$1" = . ]; then
+		cp "$here"/*.cpp "$here"/*.h "$2"
+	else
+		git -C "$top" archive "$1:$prefix" | tar -x -C "$2"
+	fi
+	cp "$here/bench/lexer.cpp" "$2/bench"
+	linked=""
+	for name in source translation interner keywords preprocessing; do
+		if [ ! -f "$2/$name.cpp" ]; then
+			continue # Not split out yet at older revisions
+		fi
+		# The program has a main of its own
+		rename=""
+		if [ $name = translation ]; then
+			rename="-Dmain=toycc_main"
+		fi
+		g++ -c $flags $rename "$2/$name.cpp" -o "$2/$name.o"
+		linked="$linked $2/$name.o"
+	done
+	g++ $flags "$2/bench/lexer.cpp" $linked -Wl,--gc-sections -o "$2/lexer"
+}
+
+build "$old" "$work/old"
+build "$new" "$work/new"
+echo "corpus: $(wc -c < "$work/corpus.c") bytes"
+echo "old ($old): $("$work/old/lexer" "$work/corpus.c")"
+echo "new ($new): $("$work/new/lexer" "$work/corpus.c")"
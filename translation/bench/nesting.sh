@@ -0,0 +1,47 @@
+#!/bin/sh
+# Times toycc on functions whose block items nest from 1 to MAX (30 by
+# default) deep, to show how parsing scales with the depth. Each file has
+# COUNT (200 by default) such functions, so that the time is not all spent
+# starting up. Before block items were parsed once, each level doubled it.
+#
+#   bench/nesting.sh [MAX]
+#
+# TOYCC is the compiler to time, ./translation in this directory by default.
+set -e
+here=$(cd "$(dirname "$0")/.." && pwd)
+toycc=${TOYCC:-$here/translation}
+max=${1:-30}
+count=${COUNT:-200}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# generate DEPTH: a function of ifs nested DEPTH deep, each with a
+# declaration and a statement in it, COUNT times
+generate() {
+	awk -v depth="$1" -v count="$count" 'BEGIN {
+		for (f = 0; f < count; ++f) {
+			print "int f" f "(int a) {"
+			for (i = 0; i < depth; ++i) {
+				print "if (a < " i ") {"
+				print "int b" i " = a;"
+				print "a = a + b" i ";"
+			}
+			for (i = 0; i < depth; ++i) {
+				print "}"
+			}
+			print "return a;"
+			print "}"
+		}
+	}'
+}
+
+echo "depth ms"
+depth=1
+while [ $depth -le "$max" ]; do
+	generate $depth > "$work/nest$depth.c"
+	start=$(date +%s%N)
+	"$toycc" "$work/nest$depth.c" > /dev/null
+	end=$(date +%s%N)
+	echo "$depth $(( (end - start) / 1000000 ))"
+	depth=$((depth + 1))
+done
@@ -0,0 +1,112 @@
+#include "../translation.h"
+#include <chrono>
+
+//Translation phases 1 and 2 as they were before the file was mapped: the file
+//is copied through two stringstreams, a character at a time
+static char trigraph(istream* input) {
+	char read = input->get();
+	if (read == '?' && input->peek() == '?') {
+		input->get();
+		switch (input->get()) {
+			case '=': read = '#'; break;
+			case '(': read = '['; break;
+			case '/': read = '\\'; break;
+			case ')': read = ']'; break;
+			case '\'': read = '^'; break;
+			case '<': read = '{'; break;
+			case '!': read = '|'; break;
+			case '>': read = '}'; break;
+			case '-': read = '~'; break;
+			default:
+				input->unget();
+				input->unget();
+				break;
+		}
+	}
+	return read;
+}
+
+static void phase1(istream* input, ostream* output) {
+	while (true) {
+		input->get();
+		if (input->eof()) {
+			break;
+		}
+		input->unget();
+		*output << trigraph(input);
+	}
+}
+
+static void phase2(istream* input, ostream* output) {
+	while (true) {
+		char read = input->get();
+		if (input->eof()) {
+			break;
+		}
+		while (read == '\\' && input->peek() == '\n') {
+			input->get();
+			read = input->get();
+		}
+		output->put(read);
+	}
+}
+
+//Sum of the characters handed to the Lexer, to compare the two
+static size_t streams(const char* filename, size_t& count) {
+	ifstream file(filename);
+	stringstream stream1to2(ios_base::in | ios_base::out | ios_base::app);
+	stringstream stream2to3(ios_base::in | ios_base::out | ios_base::app);
+	phase1(&file, &stream1to2);
+	phase2(&stream1to2, &stream2to3);
+	size_t sum = 0;
+	//The Lexer read them through a StreamSource, one at a time
+	for (int c = stream2to3.get(); c != EOF; c = stream2to3.get()) {
+		sum = 31*sum + (unsigned char) c;
+		++count;
+	}
+	return sum;
+}
+
+static size_t mapped(const char* filename, size_t& count) {
+	MappedFileSource file(filename);
+	LineSplicer splicer(&file);
+	size_t sum = 0;
+	//The BufferedSource of the Lexer pulls them a batch at a time
+	char batch[BufferedSource<char>::batchSize];
+	while (size_t got = splicer.getBatch(batch, sizeof(batch))) {
+		if (splicer.empty()) {
+			--got; //The '\0' read past the end
+		}
+		for (size_t k = 0; k < got; ++k) {
+			sum = 31*sum + (unsigned char) batch[k];
+		}
+		count += got;
+	}
+	return sum;
+}
+
+//! Prints how many bytes of a file per second phases 1 and 2 take
+/*! Both the stringstream phases which the LineSplicer replaced and the
+ * LineSplicer over a MappedFileSource are timed, on the same file. The sum
+ * printed with each is only there to see that they give the same characters.
+ */
+int main(int argc, char* argv[]) {
+	if (argc != 2) {
+		cerr << "Usage: " << argv[0] << " file" << '\n';
+		return 1;
+	}
+	MappedFileSource file(argv[1]);
+	size_t bytes = file.size();
+	const char* names[2] = {"streams", "mapped"};
+	size_t (*phases[2])(const char*, size_t&) = {streams, mapped};
+	for (int k = 0; k < 2; ++k) {
+		size_t count = 0;
+		auto start = chrono::steady_clock::now();
+		size_t sum = phases[k](argv[1], count);
+		chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+		cout << names[k] << ": " << count << " characters (sum " << sum << \
+			") in " << seconds.count() << " s, " << \
+			(size_t) (bytes / seconds.count()) << " bytes/s" << '\n';
+	}
+	return 0;
+}
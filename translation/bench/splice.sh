@@ -0,0 +1,37 @@
+#!/bin/sh
+# Compares the bytes per second of translation phases 1 and 2 through the
+# old stringstreams with a LineSplicer over a MappedFileSource, over the
+# files in test/ repeated COPIES times (2000 by default).
+#
+#   bench/splice.sh
+#
+# The stringstream phases are kept in bench/splice.cpp, so both are timed in
+# the same program, built from the working tree. Only the objects the
+# LineSplicer is in or uses are built, as in bench/lexer.sh.
+set -e
+here=$(cd "$(dirname "$0")/.." && pwd)
+copies=${COPIES:-2000}
+flags="-std=c++11 -O2 -pthread -fpermissive -w -ffunction-sections \
+	-fdata-sections"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+i=0
+while [ $i -lt "$copies" ]; do
+	cat "$here"/../test/*.c
+	i=$((i + 1))
+done > "$work/corpus.c"
+
+linked=""
+for name in source translation interner keywords preprocessing; do
+	# The program has a main of its own
+	rename=""
+	if [ $name = translation ]; then
+		rename="-Dmain=toycc_main"
+	fi
+	g++ -c $flags $rename "$here/$name.cpp" -o "$work/$name.o"
+	linked="$linked $work/$name.o"
+done
+g++ $flags "$here/bench/splice.cpp" $linked -Wl,--gc-sections -o "$work/splice"
+echo "corpus: $(wc -c < "$work/corpus.c") bytes"
+"$work/splice" "$work/corpus.c"
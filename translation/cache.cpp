@@ -0,0 +1,183 @@
+#include "translation.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+//Bump when the compiler changes in a way which the binary itself does not
+//show, the modification time and size of the binary are part of every key
+static const char* version = "toycc-result-1";
+
+ResultCache& ResultCache :: instance() {
+	static ResultCache cache;
+	return cache;
+}
+
+void ResultCache :: setDirectory(const string& dir) {
+	if (dir.length() > 0 && mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+		throw IOException("Could not create cache directory " + dir);
+	}
+	instance().directory = dir;
+}
+
+//! A 128-bit FNV-1a hash of the tokens, the options and the compiler, in hex
+string ResultCache :: key(const vector<Token>& tokens) {
+	const unsigned __int128 prime = ((unsigned __int128) 1 << 88) + 0x13b;
+	unsigned __int128 hash = ((unsigned __int128) 0x6c62272e07bb0142ULL << 64) \
+							 + 0x62b821756295c58dULL;
+	auto add = [&hash, prime](const void* data, size_t length) {
+		const unsigned char* bytes = (const unsigned char*) data;
+		for (size_t k = 0; k < length; ++k) {
+			hash = (hash ^ bytes[k]) * prime;
+		}
+	};
+	struct stat info;
+	if (stat("/proc/self/exe", &info) == 0) {
+		int64_t binary[3] = {info.st_size, info.st_mtim.tv_sec, \
+			info.st_mtim.tv_nsec};
+		add(binary, sizeof(binary));
+	}
+	add(version, strlen(version) + 1);
+	const string& options = instance().options;
+	uint64_t length = options.length();
+	add(&length, sizeof(length));
+	add(options.data(), options.length());
+	for (const Token& token : tokens) {
+		const string& name = token.getName();
+		//The length keeps the names apart, positions are left out
+		uint32_t head[2] = {(uint32_t) token.getKey(), (uint32_t) name.length()};
+		add(head, sizeof(head));
+		add(name.data(), name.length());
+	}
+	string hex;
+	for (int shift = 124; shift >= 0; shift -= 4) {
+		hex += "0123456789abcdef"[(unsigned int) (hash >> shift) & 0xf];
+	}
+	return hex;
+}
+
+bool ResultCache :: fetch(const string& key, const string& outputname) {
+	ResultCache& cache = instance();
+	string stored = cache.path(key);
+	if (!copy(stored, outputname)) {
+		++cache.misses;
+		cache.record(0, 1, 0);
+		return false;
+	}
+	//Used now, which is what eviction goes by
+	utimensat(AT_FDCWD, stored.c_str(), NULL, 0);
+	++cache.hits;
+	cache.record(1, 0, 0);
+	return true;
+}
+
+void ResultCache :: store(const string& key, const string& outputname) {
+	ResultCache& cache = instance();
+	if (!copy(outputname, cache.path(key))) {
+		throw IOException("Could not store " + outputname + " in " + \
+				cache.directory);
+	}
+	cache.evict();
+}
+
+void ResultCache :: evict() {
+	struct Result {
+		int64_t used; //Modification time in nanoseconds
+		uint64_t size;
+		string path;
+		bool operator<(const Result& other) const {return used < other.used;}
+	};
+	DIR* dir = opendir(this->directory.c_str());
+	if (dir == NULL) {
+		return;
+	}
+	vector<Result> results;
+	uint64_t total = 0;
+	while (struct dirent* entry = readdir(dir)) {
+		string name = entry->d_name;
+		struct stat info;
+		if (name.length() < 3 || name.compare(name.length() - 3, 3, ".ll") != 0 \
+				|| stat((this->directory + "/" + name).c_str(), &info) != 0) {
+			continue;
+		}
+		Result result = {info.st_mtim.tv_sec * 1000000000LL + \
+			info.st_mtim.tv_nsec, (uint64_t) info.st_size, \
+			this->directory + "/" + name};
+		results.push_back(result);
+		total += info.st_size;
+	}
+	closedir(dir);
+	if (total <= this->limit) {
+		return;
+	}
+	sort(results.begin(), results.end());
+	unsigned int evicted = 0;
+	for (size_t k = 0; k < results.size() && total > this->limit; ++k) {
+		if (unlink(results[k].path.c_str()) == 0) {
+			total -= results[k].size;
+			++evicted;
+		}
+	}
+	this->evictions += evicted;
+	this->record(0, 0, evicted);
+}
+
+//Runs may share the directory, so the counts are read and written while
+//holding a lock on 'stats.lock'. The file is replaced and never half written.
+void ResultCache :: record(unsigned int hits, unsigned int misses, \
+		unsigned int evictions) {
+	string stats = this->directory + "/stats";
+	int lock = open((stats + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+	if (lock < 0) {
+		return; //The counts are only statistics
+	}
+	if (flock(lock, LOCK_EX) != 0) {
+		close(lock);
+		return;
+	}
+	unsigned long counts[3] = {0, 0, 0};
+	const char* names[3] = {"hits", "misses", "evictions"};
+	ifstream in(stats);
+	string name;
+	unsigned long count;
+	while (in >> name >> count) {
+		for (unsigned int k = 0; k < 3; ++k) {
+			if (name == names[k]) {
+				counts[k] = count;
+			}
+		}
+	}
+	counts[0] += hits;
+	counts[1] += misses;
+	counts[2] += evictions;
+	string temporary = stats + "." + to_string(getpid());
+	ofstream out(temporary);
+	for (unsigned int k = 0; k < 3; ++k) {
+		out << names[k] << ' ' << counts[k] << '\n';
+	}
+	out.close();
+	if (!out || rename(temporary.c_str(), stats.c_str()) != 0) {
+		unlink(temporary.c_str());
+	}
+	close(lock); //Which releases it
+}
+
+//! Copies a file through a temporary file, false if it could not be read
+bool ResultCache :: copy(const string& from, const string& to) {
+	ifstream in(from, ios::binary);
+	if (!in) {
+		return false;
+	}
+	string temporary = to + "." + to_string(getpid()) + ".tmp";
+	ofstream out(temporary, ios::binary | ios::trunc);
+	out << in.rdbuf();
+	out.close();
+	if (!out || rename(temporary.c_str(), to.c_str()) != 0) {
+		unlink(temporary.c_str());
+		return false;
+	}
+	return true;
+}
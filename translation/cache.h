@@ -0,0 +1,51 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+class Token;
+
+//! An on-disk cache of the LLVM IR written for each translation unit
+/*! A result is keyed by a hash of the tokens the parser would read, i.e.
+ * after string literals have been concatenated, together with the options
+ * and the compiler itself. A unit whose tokens have not changed, e.g. after
+ * a comment was edited or the file was touched, is then not compiled again.
+ *
+ * Results are files in the cache directory named by their key. Using one
+ * updates its modification time, and when the directory grows larger than
+ * the limit the results used longest ago are removed. Counts of hits, misses
+ * and evictions over all runs are kept in the file 'stats' in the directory.
+ */
+class ResultCache {
+	public:
+		static void setDirectory(const string& dir); //--cache-dir, off if empty
+		static void setLimit(uint64_t bytes) {instance().limit = bytes;}
+		//Options which change the result but not the tokens
+		static void setOptions(const string& options) {
+			instance().options = options;
+		}
+		static bool isEnabled() {return instance().directory.length() > 0;}
+		static string key(const vector<Token>& tokens);
+		//Copies the result for the key to outputname, false if there is none
+		static bool fetch(const string& key, const string& outputname);
+		//Keeps a copy of outputname as the result for the key
+		static void store(const string& key, const string& outputname);
+		static unsigned int getHits() {return instance().hits;}
+		static unsigned int getMisses() {return instance().misses;}
+		static unsigned int getEvictions() {return instance().evictions;}
+		static const uint64_t defaultLimit = 256 << 20;
+	private:
+		ResultCache() : limit(defaultLimit), hits(0), misses(0), evictions(0) {}
+		static ResultCache& instance();
+		string path(const string& key) {return directory + "/" + key + ".ll";}
+		void evict(); //Removes the least recently used results over the limit
+		void record(unsigned int hits, unsigned int misses, \
+				unsigned int evictions); //Adds to the counts in 'stats'
+		static bool copy(const string& from, const string& to);
+		string directory;
+		uint64_t limit; //Bytes the results may take up
+		string options;
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int evictions;
+};
@@ -0,0 +1,167 @@
+#include "translation.h"
+#include <cerrno>
+#include <thread>
+#include <unistd.h>
+
+mutex DependencyScanner :: errorLock;
+
+int DependencyScanner :: run(const vector<string>& filenames, bool json, \
+		unsigned int jobs, int fd) {
+	TokenCache::setDirectivesOnly(true);
+	if (jobs > filenames.size()) {
+		jobs = filenames.size();
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	vector<string> texts(filenames.size()); //Of each unit, empty if it failed
+	atomic<size_t> next(0);
+	atomic<bool> scanned(true);
+	if (jobs == 1) {
+		scanned = scanEach(filenames, json, next, texts);
+	} else {
+		Interner::share();
+		vector<thread> workers;
+		for (unsigned int k = 0; k < jobs; ++k) {
+			workers.push_back(thread([&]() {
+				if (!scanEach(filenames, json, next, texts)) {
+					scanned = false;
+				}
+			}));
+		}
+		for (thread& worker : workers) {
+			worker.join();
+		}
+	}
+	string output;
+	if (json) {
+		output += "{\n  \"translation-units\": [\n";
+		bool first = true;
+		for (const string& text : texts) {
+			if (text.length() > 0) {
+				output += first ? "" : ",\n";
+				output += text;
+				first = false;
+			}
+		}
+		output += "\n  ]\n}\n";
+	} else {
+		for (const string& text : texts) {
+			output += text;
+		}
+	}
+	size_t written = 0;
+	while (written < output.length()) {
+		ssize_t count = ::write(fd, output.data() + written, \
+				output.length() - written);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		} else if (count < 0) {
+			string err = "Could not write dependencies";
+			throw IOException(err);
+		}
+		written += count;
+	}
+	return scanned ? 0 : 1;
+}
+
+//Scans the units not yet taken by another thread, one at a time
+bool DependencyScanner :: scanEach(const vector<string>& filenames, bool json, \
+		atomic<size_t>& next, vector<string>& texts) {
+	bool scanned = true;
+	for (size_t k = next++; k < filenames.size(); k = next++) {
+		try {
+			vector<string> dependencies = scan(filenames[k]);
+			texts[k] = json ? object(filenames[k], dependencies) : \
+				   rule(filenames[k], dependencies);
+		} catch (runtime_error& error) {
+			lock_guard<mutex> guard(errorLock);
+			cerr << "Error while scanning " << filenames[k] << ": " << \
+				error.what() << '\n';
+			scanned = false;
+		}
+	}
+	return scanned;
+}
+
+vector<string> DependencyScanner :: scan(const string& filename) {
+	Preprocessor::reset();
+	Preprocessor* preprocessor = new Preprocessor(filename);
+	while (!preprocessor->empty()) {
+		preprocessor->get();
+	}
+	delete preprocessor;
+	vector<string> dependencies(1, filename);
+	set<string> seen(dependencies.begin(), dependencies.end());
+	for (const string& file : Preprocessor::getIncludedFiles()) {
+		//Files next to the including one are found as "./name"
+		string name = file.compare(0, 2, "./") == 0 ? file.substr(2) : file;
+		if (seen.insert(name).second) {
+			dependencies.push_back(name);
+		}
+	}
+	return dependencies;
+}
+
+//The object file is named after the source file, in the current directory
+string DependencyScanner :: target(const string& filename) {
+	string name = filename.substr(filename.rfind('/') + 1);
+	string::size_type dot = name.rfind('.');
+	if (dot != string::npos && dot > 0) {
+		name.erase(dot);
+	}
+	return name + ".o";
+}
+
+//! A Make rule, like those written by gcc -M
+string DependencyScanner :: rule(const string& filename, \
+		const vector<string>& dependencies) {
+	string text = escapeMake(target(filename)) + ":";
+	for (size_t k = 0; k < dependencies.size(); ++k) {
+		text += k == 0 ? " " : " \\\n  ";
+		text += escapeMake(dependencies[k]);
+	}
+	return text + "\n";
+}
+
+string DependencyScanner :: object(const string& filename, \
+		const vector<string>& dependencies) {
+	string text = "    {\n      \"input\": \"" + escapeJson(filename) + \
+				  "\",\n      \"output\": \"" + escapeJson(target(filename)) + \
+				  "\",\n      \"dependencies\": [";
+	for (size_t k = 0; k < dependencies.size(); ++k) {
+		text += k == 0 ? "\n        \"" : ",\n        \"";
+		text += escapeJson(dependencies[k]) + "\"";
+	}
+	return text + "\n      ]\n    }";
+}
+
+string DependencyScanner :: escapeMake(const string& name) {
+	string escaped;
+	for (char c : name) {
+		if (c == ' ' || c == '#') {
+			escaped += '\\';
+		} else if (c == '$') {
+			escaped += '$';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+string DependencyScanner :: escapeJson(const string& name) {
+	string escaped;
+	for (char c : name) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if ((unsigned char) c < 0x20) {
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", (unsigned int) c);
+			escaped += code;
+		} else {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
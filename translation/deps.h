@@ -0,0 +1,38 @@
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+//! Finds the headers of translation units without compiling them
+/*! Each file is preprocessed from tokens of its directive lines only, see
+ * TokenCache::setDirectivesOnly(), so that #define, #undef and the
+ * conditionals decide which #includes are taken, like they would in a
+ * compilation. Files are lexed once for all units scanned by a process.
+ *
+ * Units can be scanned by several threads, which take the next unit as they
+ * are done with one. They share the TokenCache, so a header is lexed once
+ * however many units include it. What the preprocessor keeps for a unit,
+ * e.g. the files it included, is kept for each thread. The results are
+ * written in the order the units were given.
+ */
+class DependencyScanner {
+	public:
+		//Make rules if not json, returns 0 if all units could be scanned
+		static int run(const vector<string>& filenames, bool json, \
+				unsigned int jobs, int fd);
+		//The file itself followed by each file it includes, once each
+		static vector<string> scan(const string& filename);
+	private:
+		static string rule(const string& filename, \
+				const vector<string>& dependencies);
+		static string object(const string& filename, \
+				const vector<string>& dependencies);
+		static string target(const string& filename); //The object file
+		static string escapeMake(const string& name);
+		static string escapeJson(const string& name);
+		static bool scanEach(const vector<string>& filenames, bool json, \
+				atomic<size_t>& next, vector<string>& texts);
+		static mutex errorLock; //Held while an error is written
+};
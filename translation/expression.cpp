@@ -0,0 +1,305 @@
+#include "source.h"
+#include "expression.h"
+#include "keywords.h"
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+bool PPExpression :: evaluate(const vector<PPToken>& tokens) {
+	//Punctuators and character constants are still made of several tokens, put
+	//them together like the PostPPTokenizer does
+	vector<PPToken> merged;
+	for (size_t i = 0; i < tokens.size(); ++i) {
+		const string& name = tokens[i].getName();
+		if ((name == "L" || name == "u" || name == "U") && \
+				i + 1 < tokens.size() && tokens[i + 1].getName() == "'") {
+			continue; //The prefix of a wide character constant
+		}
+		if (name == "'") {
+			string constant = name;
+			size_t end = i + 1;
+			while (end < tokens.size() && tokens[end].getName() != "'") {
+				constant += tokens[end++].getName();
+			}
+			if (end == tokens.size()) {
+				string err = "Unterminated character constant in #if";
+				throw SyntaxException(err);
+			}
+			constant += "'";
+			merged.push_back(PPToken(tokens[i].getPosition(), constant, \
+						CHARACTERCONSTANT));
+			i = end;
+			continue;
+		}
+		if (tokens[i].getKey() == WHITESPACE || tokens[i].getKey() == IDENTIFIER \
+				|| name.length() != 1) {
+			merged.push_back(tokens[i]);
+			continue;
+		}
+		char chars[4];
+		unsigned int length = 0;
+		while (length < 4 && i + length < tokens.size() && \
+				tokens[i + length].getKey() != WHITESPACE && \
+				tokens[i + length].getName().length() == 1) {
+			chars[length] = tokens[i + length].getName()[0];
+			++length;
+		}
+		unsigned int used = punctuatorLength(chars, length);
+		if (used < 2) {
+			merged.push_back(tokens[i]);
+			continue;
+		}
+		merged.push_back(PPToken(tokens[i].getPosition(), string(chars, used), \
+					PUNCTUATOR));
+		i += used - 1;
+	}
+	PPExpression expression(merged);
+	Value value = expression.conditional(true);
+	if (expression.peek().length() > 0) {
+		string err = "Unexpected '" + expression.peek() + "' in #if";
+		throw SyntaxException(err);
+	}
+	return value.bits != 0;
+}
+
+const string& PPExpression :: peek() {
+	static const string end = "";
+	while (this->at < this->tokens.size() && \
+			this->tokens[this->at].getKey() == WHITESPACE) {
+		++this->at;
+	}
+	if (this->at < this->tokens.size()) {
+		return this->tokens[this->at].getName();
+	}
+	return end;
+}
+
+void PPExpression :: expect(const char* name) {
+	if (this->peek() != name) {
+		string err = "Expected '";
+		err += name;
+		err += "' in #if";
+		throw SyntaxException(err);
+	}
+	++this->at;
+}
+
+PPExpression::Value PPExpression :: conditional(bool evaluated) {
+	Value condition = this->binary(1, evaluated);
+	if (this->peek() != "?") {
+		return condition;
+	}
+	++this->at;
+	Value first = this->conditional(evaluated && condition.bits != 0);
+	this->expect(":");
+	Value second = this->conditional(evaluated && condition.bits == 0);
+	Value value = condition.bits != 0 ? first : second;
+	value.isUnsigned = first.isUnsigned || second.isUnsigned;
+	return value;
+}
+
+//Precedence of a binary operator, 1 binds the loosest, 0 if not one
+static unsigned int precedence(const string& op) {
+	static const map<string, unsigned int> precedences = {
+		{"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5}, {"==", 6}, \
+		{"!=", 6}, {"<", 7}, {">", 7}, {"<=", 7}, {">=", 7}, {"<<", 8}, \
+		{">>", 8}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10}};
+	auto search = precedences.find(op);
+	return search == precedences.end() ? 0 : search->second;
+}
+
+PPExpression::Value PPExpression :: binary(unsigned int level, \
+		bool evaluated) {
+	if (level > 10) {
+		return this->unary(evaluated);
+	}
+	Value left = this->binary(level + 1, evaluated);
+	while (precedence(this->peek()) == level) {
+		string op = this->peek();
+		++this->at;
+		if (op == "&&" || op == "||") {
+			bool decided = (op == "&&") == (left.bits == 0);
+			Value right = this->binary(level + 1, evaluated && !decided);
+			if (op == "&&") {
+				left.bits = left.bits != 0 && right.bits != 0;
+			} else {
+				left.bits = left.bits != 0 || right.bits != 0;
+			}
+			left.isUnsigned = false;
+		} else {
+			Value right = this->binary(level + 1, evaluated);
+			left = apply(op, left, right, evaluated);
+		}
+	}
+	return left;
+}
+
+PPExpression::Value PPExpression :: unary(bool evaluated) {
+	const string& op = this->peek();
+	if (op == "+" || op == "-" || op == "~" || op == "!") {
+		char c = op[0];
+		++this->at;
+		Value value = this->unary(evaluated);
+		if (c == '-') {
+			value.bits = -value.bits;
+		} else if (c == '~') {
+			value.bits = ~value.bits;
+		} else if (c == '!') {
+			value.bits = value.bits == 0;
+			value.isUnsigned = false;
+		}
+		return value;
+	}
+	return this->primary(evaluated);
+}
+
+PPExpression::Value PPExpression :: primary(bool evaluated) {
+	const string& name = this->peek();
+	if (name == "(") {
+		++this->at;
+		Value value = this->conditional(evaluated);
+		this->expect(")");
+		return value;
+	}
+	if (name.length() == 0) {
+		string err = "Expected an expression in #if";
+		throw SyntaxException(err);
+	}
+	const PPToken& token = this->tokens[this->at++];
+	if (token.getKey() == PPNUMBER) {
+		return number(name);
+	} else if (token.getKey() == CHARACTERCONSTANT) {
+		return character(name);
+	} else if (token.getKey() == IDENTIFIER) {
+		//Not a macro, so it is replaced by 0
+		Value value = {0, false};
+		return value;
+	}
+	string err = "Unexpected '" + name + "' in #if";
+	throw SyntaxException(err);
+}
+
+PPExpression::Value PPExpression :: apply(const string& op, \
+		Value a, Value b, bool evaluated) {
+	Value value = {0, a.isUnsigned || b.isUnsigned};
+	intmax_t sa = (intmax_t) a.bits;
+	intmax_t sb = (intmax_t) b.bits;
+	char c = op[0];
+	if (op == "*") {
+		value.bits = a.bits * b.bits;
+	} else if (op == "/" || op == "%") {
+		if (b.bits == 0) {
+			if (evaluated) {
+				string err = "Division by zero in #if";
+				throw SyntaxException(err);
+			}
+		} else if (value.isUnsigned) {
+			value.bits = c == '/' ? a.bits / b.bits : a.bits % b.bits;
+		} else if (sb == -1) {
+			value.bits = c == '/' ? -a.bits : 0; //Also for INTMAX_MIN
+		} else {
+			value.bits = c == '/' ? sa / sb : sa % sb;
+		}
+	} else if (op == "+") {
+		value.bits = a.bits + b.bits;
+	} else if (op == "-") {
+		value.bits = a.bits - b.bits;
+	} else if (op == "<<" || op == ">>") {
+		value.isUnsigned = a.isUnsigned;
+		bool tooFar = (!b.isUnsigned && sb < 0) || b.bits >= 8*sizeof(uintmax_t);
+		if (c == '<') {
+			value.bits = tooFar ? 0 : a.bits << b.bits;
+		} else if (value.isUnsigned) {
+			value.bits = tooFar ? 0 : a.bits >> b.bits;
+		} else {
+			value.bits = tooFar ? (sa < 0 ? -1 : 0) : sa >> b.bits;
+		}
+	} else if (op == "==" || op == "!=") {
+		value.bits = (a.bits == b.bits) == (op == "==");
+		value.isUnsigned = false;
+	} else if (c == '<' || c == '>') {
+		bool less = value.isUnsigned ? a.bits < b.bits : sa < sb;
+		bool greater = value.isUnsigned ? a.bits > b.bits : sa > sb;
+		if (op.length() == 2) {
+			value.bits = c == '<' ? !greater : !less;
+		} else {
+			value.bits = c == '<' ? less : greater;
+		}
+		value.isUnsigned = false;
+	} else if (op == "&") {
+		value.bits = a.bits & b.bits;
+	} else if (op == "^") {
+		value.bits = a.bits ^ b.bits;
+	} else if (op == "|") {
+		value.bits = a.bits | b.bits;
+	}
+	return value;
+}
+
+PPExpression::Value PPExpression :: number(const string& name) {
+	Value value = {0, false};
+	size_t end = name.length();
+	while (end > 0 && strchr("uUlL", name[end - 1]) != NULL) {
+		if (name[end - 1] == 'u' || name[end - 1] == 'U') {
+			value.isUnsigned = true;
+		}
+		--end;
+	}
+	string digits = name.substr(0, end);
+	bool hex = digits.length() > 2 && digits[0] == '0' && \
+			   (digits[1] == 'x' || digits[1] == 'X');
+	size_t invalid = hex ? digits.find_first_not_of("0123456789abcdefABCDEF", 2) \
+				   : digits.find_first_not_of("0123456789");
+	if (digits.length() == 0 || invalid != string::npos) {
+		string err = "Invalid integer constant '" + name + "' in #if";
+		throw SyntaxException(err);
+	}
+	errno = 0;
+	int base = hex ? 16 : (digits[0] == '0' ? 8 : 10);
+	char* last;
+	value.bits = strtoumax(digits.c_str(), &last, base);
+	if (*last != '\0' || errno == ERANGE) {
+		string err = "Invalid integer constant '" + name + "' in #if";
+		throw SyntaxException(err);
+	}
+	if (value.bits > (uintmax_t) INTMAX_MAX) {
+		value.isUnsigned = true; //Too large to be signed
+	}
+	return value;
+}
+
+PPExpression::Value PPExpression :: character(const string& name) {
+	Value value = {0, false};
+	size_t at = name.find('\'') + 1;
+	bool plain = at == 1;
+	while (at < name.length() && name[at] != '\'') {
+		uintmax_t c = (unsigned char) name[at++];
+		if (c == '\\' && at < name.length()) {
+			c = (unsigned char) name[at++];
+			if (c >= '0' && c <= '7') {
+				c -= '0';
+				for (int i = 1; i < 3 && name[at] >= '0' && name[at] <= '7'; ++i) {
+					c = 8*c + (name[at++] - '0');
+				}
+			} else if (c == 'x') {
+				c = 0;
+				while (isxdigit(name[at])) {
+					char d = name[at++];
+					c = 16*c + (isdigit(d) ? d - '0' : (tolower(d) - 'a' + 10));
+				}
+			} else {
+				const char* escapes = "a\ab\bf\fn\nr\rt\tv\v";
+				const char* found = strchr(escapes, (char) c);
+				if (found != NULL && (found - escapes) % 2 == 0) {
+					c = (unsigned char) found[1];
+				}
+			}
+		}
+		value.bits = plain ? (value.bits << 8) | (c & 0xff) : c;
+	}
+	if (plain) {
+		//A char is signed, as in gcc
+		value.bits = (uintmax_t) (intmax_t) (int) (signed char) value.bits;
+	}
+	return value;
+}
@@ -0,0 +1,37 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+class PPToken;
+
+//! Evaluates the controlling expression of an #if or #elif (C11 6.10.1)
+/*! The tokens are those of the directive after macro expansion, with every
+ * defined operator already replaced by 0 or 1. Identifiers which are left are
+ * 0, and all arithmetic is done in intmax_t or uintmax_t.
+ */
+class PPExpression {
+	public:
+		//True if the expression is not zero
+		static bool evaluate(const vector<PPToken>& tokens);
+	private:
+		struct Value {
+			uintmax_t bits; //Two's complement if not unsigned
+			bool isUnsigned;
+		};
+		PPExpression(const vector<PPToken>& tokens) : tokens(tokens), \
+															at(0) {}
+		const vector<PPToken>& tokens;
+		size_t at; //Index of the next token
+		const string& peek(); //Name of the next token which is not white-space
+		void expect(const char* name);
+		//Each of these parses one level of the grammar. Division by zero is only
+		//an error if 'evaluated', i.e. not skipped by &&, || or ?:
+		Value conditional(bool evaluated);
+		Value binary(unsigned int precedence, bool evaluated);
+		Value unary(bool evaluated);
+		Value primary(bool evaluated);
+		static Value apply(const string& op, Value a, Value b, bool evaluated);
+		static Value number(const string& name);
+		static Value character(const string& name);
+};
@@ -0,0 +1,113 @@
+#include "includes.h"
+#include <dirent.h>
+
+IncludeResolver :: IncludeResolver() : lookups(0), cacheHits(0), probes(0), \
+									   reads(0) {
+	this->defaultDirectories.push_back("/usr/local/include");
+	this->defaultDirectories.push_back("/usr/include");
+}
+
+IncludeResolver& IncludeResolver :: instance() {
+	static IncludeResolver resolver;
+	return resolver;
+}
+
+void IncludeResolver :: addQuoteDirectory(const string& dir) {
+	instance().quoteDirectories.push_back(dir);
+}
+
+void IncludeResolver :: addDirectory(const string& dir) {
+	instance().directories.push_back(dir);
+}
+
+void IncludeResolver :: addSystemDirectory(const string& dir) {
+	instance().systemDirectories.push_back(dir);
+}
+
+string IncludeResolver :: resolve(const string& name, bool quoted, \
+		const string& includer) {
+	IncludeResolver& resolver = instance();
+	lock_guard<mutex> guard(resolver.lock);
+	++resolver.lookups;
+	if (name.length() > 0 && name[0] == '/') {
+		return resolver.exists("", name) ? name : "";
+	}
+	string includerDirectory = ".";
+	string::size_type slash = includer.rfind('/');
+	if (slash != string::npos) {
+		includerDirectory = includer.substr(0, slash);
+	}
+	//Only quoted includes depend on where the includer is
+	string key = quoted ? "\"" + includerDirectory + '\0' + name : "<" + name;
+	auto search = resolver.resolved.find(key);
+	if (search != resolver.resolved.end()) {
+		++resolver.cacheHits;
+		return search->second;
+	}
+	vector<const vector<string>*> order;
+	vector<string> includerDirectories(1, includerDirectory);
+	if (quoted) {
+		order.push_back(&includerDirectories);
+		order.push_back(&resolver.quoteDirectories);
+	}
+	order.push_back(&resolver.directories);
+	order.push_back(&resolver.systemDirectories);
+	order.push_back(&resolver.defaultDirectories);
+	string path = "";
+	for (const vector<string>* dirs : order) {
+		for (const string& dir : *dirs) {
+			if (resolver.exists(dir, name)) {
+				path = dir + "/" + name;
+				break;
+			}
+		}
+		if (path.length() > 0) {
+			break;
+		}
+	}
+	resolver.resolved[key] = path; //Also remember that it was not found
+	return path;
+}
+
+bool IncludeResolver :: isSystem(const string& path) {
+	IncludeResolver& resolver = instance();
+	lock_guard<mutex> guard(resolver.lock);
+	for (const vector<string>* dirs : {&resolver.systemDirectories, \
+			&resolver.defaultDirectories}) {
+		for (const string& dir : *dirs) {
+			if (path.compare(0, dir.length() + 1, dir + "/") == 0) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//! True if the directory holds a file with the name, which may have directories
+bool IncludeResolver :: exists(const string& dir, const string& name) {
+	++this->probes;
+	string path = dir + "/" + name;
+	string::size_type slash = path.rfind('/');
+	return this->listing(path.substr(0, slash)).count(path.substr(slash + 1)) > 0;
+}
+
+//! The files in a directory, which is empty if it can not be read
+const set<string>& IncludeResolver :: listing(const string& dir) {
+	auto search = this->listings.find(dir);
+	if (search != this->listings.end()) {
+		return search->second;
+	}
+	++this->reads;
+	set<string>& files = this->listings[dir];
+	DIR* stream = opendir(dir.length() > 0 ? dir.c_str() : "/");
+	if (stream != NULL) {
+		struct dirent* entry;
+		while ((entry = readdir(stream)) != NULL) {
+			if (entry->d_type != DT_DIR) {
+				files.insert(entry->d_name);
+			}
+		}
+		closedir(stream);
+	}
+	return files;
+}
@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+using namespace std;
+
+//! Finds the file an #include refers to, through the include search paths
+/*! A quoted include is looked for in the directory of the including file,
+ * then in the -iquote, -I and -isystem directories, and last in the system
+ * directories. An include in angle brackets skips the first two.
+ *
+ * Directories are read once and their listings are kept, so probing for a
+ * file in a directory it is not in costs no system call after the first time.
+ * Resolved includes are kept as well. Includes may be resolved from several
+ * threads, one at a time.
+ */
+class IncludeResolver {
+	public:
+		static void addQuoteDirectory(const string& dir); //-iquote
+		static void addDirectory(const string& dir); //-I
+		static void addSystemDirectory(const string& dir); //-isystem
+		//The path of the file, or the empty string if it could not be found
+		static string resolve(const string& name, bool quoted, \
+				const string& includer);
+		//True if the path is in a -isystem or a system directory
+		static bool isSystem(const string& path);
+		static unsigned int getLookups() {return instance().lookups;}
+		static unsigned int getCacheHits() {return instance().cacheHits;}
+		static unsigned int getProbes() {return instance().probes;}
+		static unsigned int getDirectoryReads() {return instance().reads;}
+		//Probes which did not need a system call
+		static unsigned int getStatsSaved() {
+			return instance().probes - instance().reads;
+		}
+	private:
+		IncludeResolver();
+		static IncludeResolver& instance();
+		bool exists(const string& dir, const string& name);
+		const set<string>& listing(const string& dir);
+		vector<string> quoteDirectories;
+		vector<string> directories;
+		vector<string> systemDirectories;
+		vector<string> defaultDirectories;
+		map<string, string> resolved; //Keyed by kind, includer and name
+		map<string, set<string> > listings; //Files in each directory
+		unsigned int lookups;
+		unsigned int cacheHits;
+		unsigned int probes;
+		unsigned int reads;
+		mutex lock; //Held by resolve()
+};
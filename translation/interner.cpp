@@ -0,0 +1,114 @@
+#include "interner.h"
+#include <algorithm>
+#include <cstring>
+
+//Spelling of each KnownSymbol, in the same order
+static const char* symbolNames[] = {"", "", "\n", "#", \
+	";", ",", "=", "{", "}", ":", \
+	"(", ")", "*", ".", "<", "\"", \
+	"'", \
+	"while", "do", "for", "_Atomic", "struct", "union", "enum", \
+	"include", "define", "undef", "pragma", "if", "ifdef", \
+	"ifndef", "elif", "else", "endif", "defined", "once"};
+static_assert(sizeof(symbolNames) / sizeof(symbolNames[0]) == SYMBOLS, \
+		"Each KnownSymbol needs a name");
+
+Interner :: Interner() : chunks(NULL), chunkCount(0), chunkCapacity(0), \
+						   count(1), shared(false), slots(1024, 0), mask(1023) {
+	this->addChunk();
+	this->hashes.push_back(0);
+	this->insert("\0", 1); //SYM_NUL, the only name which is not a C string
+	for (unsigned int symbol = SYM_NUL + 1; symbol < SYMBOLS; ++symbol) {
+		this->insert(symbolNames[symbol], strlen(symbolNames[symbol]));
+	}
+}
+
+unsigned int Interner :: insert(const char* chars, size_t length) {
+	if (length == 0) {
+		return 0;
+	}
+	Interner& table = *this;
+	size_t hash = Interner::hash(chars, length);
+	size_t slot = table.probe(chars, length, hash);
+	if (table.slots[slot] != 0) {
+		return table.slots[slot] - 1;
+	}
+	unsigned int symbol = table.count;
+	if ((symbol & chunkMask) == 0) {
+		table.addChunk();
+	}
+	string** chunks = table.chunks.load(memory_order_relaxed);
+	chunks[symbol >> chunkBits][symbol & chunkMask].assign(chars, length);
+	++table.count;
+	table.hashes.push_back(hash);
+	table.slots[slot] = symbol + 1;
+	if (2*table.count > table.slots.size()) {
+		table.grow();
+	}
+	return symbol;
+}
+
+bool Interner :: search(const char* chars, size_t length, \
+		unsigned int& symbol) {
+	if (length == 0) {
+		symbol = 0;
+		return true;
+	}
+	size_t slot = this->probe(chars, length, Interner::hash(chars, length));
+	if (this->slots[slot] == 0) {
+		return false;
+	}
+	symbol = this->slots[slot] - 1;
+	return true;
+}
+
+size_t Interner :: probe(const char* chars, size_t length, size_t hash) {
+	size_t slot = hash & this->mask;
+	while (this->slots[slot] != 0) {
+		unsigned int symbol = this->slots[slot] - 1;
+		const string& str = lookup(symbol);
+		if (this->hashes[symbol] == hash && str.length() == length && \
+				memcmp(str.data(), chars, length) == 0) {
+			return slot;
+		}
+		slot = (slot + 1) & this->mask;
+	}
+	return slot;
+}
+
+//! FNV-1a
+size_t Interner :: hash(const char* chars, size_t length) {
+	size_t hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i) {
+		hash = (hash ^ (unsigned char) chars[i]) * 16777619u;
+	}
+	return hash;
+}
+
+void Interner :: grow() {
+	vector<unsigned int> larger(2*this->slots.size(), 0);
+	size_t largerMask = larger.size() - 1;
+	for (unsigned int symbol = 1; symbol < this->count; ++symbol) {
+		size_t slot = this->hashes[symbol] & largerMask;
+		while (larger[slot] != 0) {
+			slot = (slot + 1) & largerMask;
+		}
+		larger[slot] = symbol + 1;
+	}
+	this->slots.swap(larger);
+	this->mask = largerMask;
+}
+
+void Interner :: addChunk() {
+	string** table = this->chunks.load(memory_order_relaxed);
+	if (this->chunkCount == this->chunkCapacity) {
+		this->chunkCapacity = this->chunkCapacity == 0 ? 16 : \
+							  2*this->chunkCapacity;
+		string** larger = new string*[this->chunkCapacity];
+		copy(table, table + this->chunkCount, larger);
+		this->tables.push_back(larger);
+		table = larger;
+	}
+	table[this->chunkCount++] = new string[1 << chunkBits];
+	this->chunks.store(table, memory_order_release);
+}
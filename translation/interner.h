@@ -0,0 +1,91 @@
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+using namespace std;
+
+//! Symbols of the names compared against while translating
+/*! The Interner interns these first, in this order, so a token can be
+ * compared to one of them by its symbol alone. See symbolNames in
+ * interner.cpp for how each is spelled.
+ */
+enum KnownSymbol : unsigned int {SYM_EMPTY, SYM_NUL, SYM_NEWLINE, SYM_HASH, \
+	SYM_SEMICOLON, SYM_COMMA, SYM_ASSIGN, SYM_LBRACE, SYM_RBRACE, SYM_COLON, \
+	SYM_LPAREN, SYM_RPAREN, SYM_STAR, SYM_DOT, SYM_LESS, SYM_QUOTE, \
+	SYM_APOSTROPHE, \
+	SYM_WHILE, SYM_DO, SYM_FOR, SYM_ATOMIC, SYM_STRUCT, SYM_UNION, SYM_ENUM, \
+	SYM_INCLUDE, SYM_DEFINE, SYM_UNDEF, SYM_PRAGMA, SYM_IF, SYM_IFDEF, \
+	SYM_IFNDEF, SYM_ELIF, SYM_ELSE, SYM_ENDIF, SYM_DEFINED, SYM_ONCE, \
+	SYMBOLS};
+
+//! A table of interned strings, each identified by a 32-bit symbol
+/*! Interning the same characters twice gives the same symbol, so two names
+ * are equal exactly when their symbols are. Strings are never removed and are
+ * kept in chunks which never move, so references given out by lookup() stay
+ * valid. The empty string is always symbol 0.
+ *
+ * Once shared, intern() takes a lock so that other threads can intern as
+ * well. lookup() never needs one: when the table of chunks is full, a larger
+ * copy is made and published, and the old table is kept for threads which
+ * may still be reading it. So a table never changes under a reader, except
+ * for slots past the symbols it can have been given.
+ */
+class Interner {
+	public:
+		static unsigned int intern(const char* chars, size_t length) {
+			Interner& table = instance();
+			if (!table.shared) {
+				return table.insert(chars, length);
+			}
+			lock_guard<mutex> guard(table.lock);
+			return table.insert(chars, length);
+		}
+		static unsigned int intern(const string& str) {
+			return intern(str.data(), str.length());
+		}
+		//Gives the symbol of a string which has been interned, without
+		//interning it. False if it has not been.
+		static bool find(const char* chars, size_t length, unsigned int& symbol) {
+			Interner& table = instance();
+			if (!table.shared) {
+				return table.search(chars, length, symbol);
+			}
+			lock_guard<mutex> guard(table.lock);
+			return table.search(chars, length, symbol);
+		}
+		static bool find(const string& str, unsigned int& symbol) {
+			return find(str.data(), str.length(), symbol);
+		}
+		static const string& lookup(unsigned int symbol) {
+			string** table = instance().chunks.load(memory_order_acquire);
+			return table[symbol >> chunkBits][symbol & chunkMask];
+		}
+		static size_t size() {return instance().count;}
+		//Allow threads to intern, before the first thread is started
+		static void share() {instance().shared = true;}
+	private:
+		Interner();
+		static Interner& instance() {
+			static Interner interner;
+			return interner;
+		}
+		unsigned int insert(const char* chars, size_t length);
+		bool search(const char* chars, size_t length, unsigned int& symbol);
+		//The slot of the string, or the free slot where it would be put
+		size_t probe(const char* chars, size_t length, size_t hash);
+		static size_t hash(const char* chars, size_t length);
+		void grow(); //Double the number of slots and rehash
+		void addChunk(); //Room for the next 1 << chunkBits symbols
+		static const unsigned int chunkBits = 12;
+		static const unsigned int chunkMask = (1 << chunkBits) - 1;
+		atomic<string**> chunks; //Of 1 << chunkBits strings each, by symbol
+		size_t chunkCount;
+		size_t chunkCapacity; //Of the table of chunks
+		vector<string**> tables; //Every table of chunks made, the last in use
+		size_t count; //Number of strings
+		bool shared;
+		mutex lock;
+		vector<size_t> hashes; //Hash of each string, indexed by symbol
+		vector<unsigned int> slots; //Open addressing, symbol + 1 or 0 if free
+		size_t mask; //slots.size() - 1
+};
@@ -0,0 +1,179 @@
+#include "keywords.h"
+#include <cstring>
+
+//Keywords are recognized by a switch on the length and then on the character
+//which tells the most keywords of that length apart, so at most one or two
+//memcmp() calls are made. Punctuators are recognized by a trie written out as
+//nested switches, which gives maximal munch in a single pass.
+
+static inline bool spelled(const char* chars, const char* keyword, \
+		size_t length) {
+	return memcmp(chars, keyword, length) == 0;
+}
+
+bool isKeyword(const char* chars, size_t length) {
+	switch (length) {
+		case 2:
+			switch (chars[0]) {
+				case 'd':
+					return spelled(chars, "do", 2);
+				case 'i':
+					return spelled(chars, "if", 2);
+			}
+			return false;
+		case 3:
+			switch (chars[0]) {
+				case 'f':
+					return spelled(chars, "for", 3);
+				case 'i':
+					return spelled(chars, "int", 3);
+			}
+			return false;
+		case 4:
+			switch (chars[0]) {
+				case 'a':
+					return spelled(chars, "auto", 4);
+				case 'c':
+					return spelled(chars, "case", 4) || \
+						spelled(chars, "char", 4);
+				case 'e':
+					return spelled(chars, "else", 4) || \
+						spelled(chars, "enum", 4);
+				case 'g':
+					return spelled(chars, "goto", 4);
+				case 'l':
+					return spelled(chars, "long", 4);
+				case 'v':
+					return spelled(chars, "void", 4);
+			}
+			return false;
+		case 5:
+			switch (chars[0]) {
+				case '_':
+					return spelled(chars, "_Bool", 5);
+				case 'b':
+					return spelled(chars, "break", 5);
+				case 'c':
+					return spelled(chars, "const", 5);
+				case 'f':
+					return spelled(chars, "float", 5);
+				case 's':
+					return spelled(chars, "short", 5);
+				case 'u':
+					return spelled(chars, "union", 5);
+				case 'w':
+					return spelled(chars, "while", 5);
+			}
+			return false;
+		case 6:
+			switch (chars[2]) {
+				case 'a':
+					return spelled(chars, "static", 6);
+				case 'g':
+					return spelled(chars, "signed", 6);
+				case 'i':
+					return spelled(chars, "switch", 6);
+				case 'l':
+					return spelled(chars, "inline", 6);
+				case 'r':
+					return spelled(chars, "struct", 6);
+				case 't':
+					return spelled(chars, "extern", 6) || \
+						spelled(chars, "return", 6);
+				case 'u':
+					return spelled(chars, "double", 6);
+				case 'z':
+					return spelled(chars, "sizeof", 6);
+			}
+			return false;
+		case 7:
+			switch (chars[0]) {
+				case '_':
+					return spelled(chars, "_Atomic", 7);
+				case 'd':
+					return spelled(chars, "default", 7);
+				case 't':
+					return spelled(chars, "typedef", 7);
+			}
+			return false;
+		case 8:
+			switch (chars[7]) {
+				case 'c':
+					return spelled(chars, "_Generic", 8);
+				case 'd':
+					return spelled(chars, "unsigned", 8);
+				case 'e':
+					return spelled(chars, "continue", 8) || \
+						spelled(chars, "volatile", 8);
+				case 'f':
+					return spelled(chars, "_Alignof", 8);
+				case 'r':
+					return spelled(chars, "register", 8);
+				case 's':
+					return spelled(chars, "_Alignas", 8);
+				case 't':
+					return spelled(chars, "restrict", 8);
+				case 'x':
+					return spelled(chars, "_Complex", 8);
+			}
+			return false;
+		case 9:
+			return spelled(chars, "_Noreturn", 9);
+		case 10:
+			return spelled(chars, "_Imaginary", 10);
+		case 13:
+			return spelled(chars, "_Thread_local", 13);
+		case 14:
+			return spelled(chars, "_Static_assert", 14);
+	}
+	return false;
+}
+
+unsigned int punctuatorLength(const char* chars, size_t length) {
+	if (length == 0) {
+		return 0;
+	}
+	char second = length > 1 ? chars[1] : '\0';
+	char third = length > 2 ? chars[2] : '\0';
+	switch (chars[0]) {
+		case '[': case ']': case '(': case ')': case '{': case '}':
+		case '~': case '?': case ';': case ',':
+			return 1;
+		case '.':
+			return (second == '.' && third == '.') ? 3 : 1;
+		case '-':
+			return (second == '>' || second == '-' || second == '=') ? 2 : 1;
+		case '+':
+			return (second == '+' || second == '=') ? 2 : 1;
+		case '&':
+			return (second == '&' || second == '=') ? 2 : 1;
+		case '|':
+			return (second == '|' || second == '=') ? 2 : 1;
+		case '*': case '/': case '!': case '=': case '^':
+			return second == '=' ? 2 : 1;
+		case '#':
+			return second == '#' ? 2 : 1;
+		case ':':
+			return second == '>' ? 2 : 1;
+		case '<':
+			if (second == '<') {
+				return third == '=' ? 3 : 2;
+			}
+			return (second == '=' || second == ':' || second == '%') ? 2 : 1;
+		case '>':
+			if (second == '>') {
+				return third == '=' ? 3 : 2;
+			}
+			return second == '=' ? 2 : 1;
+		case '%':
+			if (second == ':') {
+				//%:%: is the digraph of ##
+				if (third == '%' && length > 3 && chars[3] == ':') {
+					return 4;
+				}
+				return 2;
+			}
+			return (second == '=' || second == '>') ? 2 : 1;
+	}
+	return 0;
+}
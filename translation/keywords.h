@@ -0,0 +1,8 @@
+#include <cstddef>
+
+//! True if the characters spell one of the C11 keywords
+bool isKeyword(const char* chars, size_t length);
+//! Length of the longest C11 punctuator the characters start with, 0 if none
+/*! Digraphs are included. At most four characters are looked at.
+ */
+unsigned int punctuatorLength(const char* chars, size_t length);
@@ -0,0 +1,279 @@
+#include "translation.h"
+#include <cstring>
+
+PrecompiledHeader* PrecompiledHeader :: included = NULL;
+const unsigned int PrecompiledHeader :: noSymbol;
+
+static const char magic[8] = {'t', 'o', 'y', 'c', 'c', 'p', 'c', 'h'};
+
+PrecompiledHeader :: PrecompiledHeader(const string& filename) : \
+	source(new MappedFileSource(filename)), filename(filename) {
+	this->data = this->source->getData();
+	size_t length = this->source->size();
+	const Header* head = (const Header*) this->data;
+	bool valid = length >= sizeof(Header) && \
+				 memcmp(head->magic, magic, sizeof(magic)) == 0 && \
+				 head->version == version;
+	if (valid) {
+		//Every table has to be inside the file
+		uint64_t tables[][3] = {
+			{head->strings, head->stringCount, sizeof(StringEntry)},
+			{head->tokens, head->tokenCount, sizeof(TokenEntry)},
+			{head->macros, head->macroCount, sizeof(MacroEntry)},
+			{head->files, head->fileCount, sizeof(FileEntry)},
+			{head->chars, head->charCount, 1}};
+		for (unsigned int k = 0; valid && k < 5; ++k) {
+			valid = tables[k][0] <= length && \
+					tables[k][1] <= (length - tables[k][0]) / tables[k][2];
+		}
+	}
+	if (!valid) {
+		delete this->source;
+		throw IOException(filename + " is not a precompiled header of version " + \
+				to_string(version));
+	}
+	this->stringCount = head->stringCount;
+	this->tokenCount = head->tokenCount;
+	this->macroCount = head->macroCount;
+	this->fileCount = head->fileCount;
+	this->strings = (const StringEntry*) (this->data + head->strings);
+	this->tokens = (const TokenEntry*) (this->data + head->tokens);
+	this->macros = (const MacroEntry*) (this->data + head->macros);
+	this->files = (const FileEntry*) (this->data + head->files);
+	this->text = this->data + head->chars;
+	this->textLength = head->charCount;
+	this->symbols = vector<atomic<unsigned int>>(this->stringCount);
+	for (atomic<unsigned int>& symbol : this->symbols) {
+		symbol.store(noSymbol, memory_order_relaxed);
+	}
+	size_t nameLength;
+	const char* name = this->chars(head->header, nameLength);
+	this->header.assign(name, nameLength);
+	//The header itself must not have changed since it was precompiled
+	struct stat info;
+	if (stat(this->header.c_str(), &info) != 0 || \
+			(uint64_t) info.st_size != head->size || \
+			info.st_mtim.tv_sec != head->modified || \
+			info.st_mtim.tv_nsec != head->modifiedNanoseconds) {
+		delete this->source;
+		throw IOException(filename + " is out of date, " + this->header + \
+				" has changed");
+	}
+}
+
+PrecompiledHeader :: ~PrecompiledHeader() {
+	delete this->source;
+}
+
+void PrecompiledHeader :: include(const string& filename) {
+	delete included;
+	included = new PrecompiledHeader(filename);
+}
+
+//! Writes a precompiled header, all tables first and the characters last
+void PrecompiledHeader :: write(const string& filename, const string& header, \
+		const vector<PPToken>& tokens, const map<string, Macro*>& macros, \
+		const map<string, string>& guards, const set<string>& onceFiles) {
+	vector<StringEntry> strings;
+	string text;
+	vector<uint32_t> indices(Interner::size(), (uint32_t) -1); //Of each symbol
+	auto add = [&](unsigned int symbol) -> uint32_t {
+		if (symbol >= indices.size()) {
+			indices.resize(Interner::size(), (uint32_t) -1);
+		}
+		if (indices[symbol] == (uint32_t) -1) {
+			const string& name = Interner::lookup(symbol);
+			StringEntry entry = {text.length(), name.length()};
+			indices[symbol] = strings.size();
+			strings.push_back(entry);
+			text += name;
+		}
+		return indices[symbol];
+	};
+	auto entry = [&](const PPToken& token) -> TokenEntry {
+		TokenEntry entry = {add(token.getSymbol()), (uint32_t) token.getKey(), \
+			token.getLine(), token.getColumn()};
+		return entry;
+	};
+	Header head;
+	memset(&head, 0, sizeof(head));
+	memcpy(head.magic, magic, sizeof(magic));
+	head.version = version;
+	//Kept canonical, so that the header is found from any directory
+	string path = TokenCache::canonicalPath(header);
+	struct stat info;
+	if (path.length() == 0 || stat(path.c_str(), &info) != 0) {
+		throw IOException("Could not stat file " + header);
+	}
+	head.header = add(Interner::intern(path));
+	head.size = info.st_size;
+	head.modified = info.st_mtim.tv_sec;
+	head.modifiedNanoseconds = info.st_mtim.tv_nsec;
+	vector<TokenEntry> tokenEntries;
+	tokenEntries.reserve(tokens.size());
+	for (const PPToken& token : tokens) {
+		tokenEntries.push_back(entry(token));
+	}
+	//The map is sorted by name, as materialize() expects. The parameters and
+	//the body of each macro are written as they were in the #define.
+	vector<MacroEntry> macroEntries;
+	vector<TokenEntry> macroTokens;
+	for (auto& pair : macros) {
+		const Macro* macro = pair.second;
+		MacroEntry macroEntry = {add(Interner::intern(pair.first)), \
+			dynamic_cast<const FunctionMacro*>(macro) != NULL, \
+			(uint32_t) macro->getParameterCount(), \
+			(uint32_t) macro->getOps().size(), macroTokens.size()};
+		for (size_t k = 0; k < macro->getParameterCount(); ++k) {
+			macroTokens.push_back(entry(macro->getParameter(k)));
+		}
+		for (const MacroOp& op : macro->getOps()) {
+			macroTokens.push_back(entry(op.isParameter() ? \
+						macro->getParameter(op.getIndex()) : \
+						macro->getToken(op.getIndex())));
+		}
+		macroEntries.push_back(macroEntry);
+	}
+	vector<FileEntry> fileEntries;
+	set<string> files(onceFiles);
+	for (auto& pair : guards) {
+		files.insert(pair.first);
+	}
+	for (const string& file : files) {
+		auto guard = guards.find(file);
+		FileEntry fileEntry = {add(Interner::intern(file)), \
+			add(Interner::intern(guard != guards.end() ? guard->second : "")), \
+			(uint32_t) onceFiles.count(file), 0};
+		fileEntries.push_back(fileEntry);
+	}
+	head.stringCount = strings.size();
+	head.tokenCount = tokenEntries.size();
+	head.macroCount = macroEntries.size();
+	head.fileCount = fileEntries.size();
+	head.strings = sizeof(Header);
+	head.tokens = head.strings + strings.size() * sizeof(StringEntry);
+	head.macros = head.tokens + tokenEntries.size() * sizeof(TokenEntry);
+	uint64_t macroTokensAt = head.macros + macroEntries.size() * \
+							 sizeof(MacroEntry);
+	for (MacroEntry& macroEntry : macroEntries) {
+		macroEntry.tokens = macroTokensAt + macroEntry.tokens * sizeof(TokenEntry);
+	}
+	head.files = macroTokensAt + macroTokens.size() * sizeof(TokenEntry);
+	head.chars = head.files + fileEntries.size() * sizeof(FileEntry);
+	head.charCount = text.length();
+	ofstream out(filename, ios::binary | ios::trunc);
+	out.write((const char*) &head, sizeof(head));
+	out.write((const char*) strings.data(), strings.size() * sizeof(StringEntry));
+	out.write((const char*) tokenEntries.data(), \
+			tokenEntries.size() * sizeof(TokenEntry));
+	out.write((const char*) macroEntries.data(), \
+			macroEntries.size() * sizeof(MacroEntry));
+	out.write((const char*) macroTokens.data(), \
+			macroTokens.size() * sizeof(TokenEntry));
+	out.write((const char*) fileEntries.data(), \
+			fileEntries.size() * sizeof(FileEntry));
+	out.write(text.data(), text.length());
+	out.close();
+	if (!out) {
+		throw IOException("Could not write precompiled header " + filename);
+	}
+}
+
+//! The characters of a string of the file, which are not null-terminated
+const char* PrecompiledHeader :: chars(uint32_t string, size_t& length) const {
+	if (string >= this->stringCount || \
+			this->strings[string].offset > this->textLength || \
+			this->strings[string].length > \
+			this->textLength - this->strings[string].offset) {
+		throw IOException(this->filename + " is corrupt");
+	}
+	length = this->strings[string].length;
+	return this->text + this->strings[string].offset;
+}
+
+//Threads which intern the same string get the same symbol, so they may race
+unsigned int PrecompiledHeader :: symbol(uint32_t string) {
+	if (string >= this->stringCount) {
+		size_t length;
+		this->chars(string, length); //Throws, the header is corrupt
+	}
+	unsigned int symbol = this->symbols[string].load(memory_order_relaxed);
+	if (symbol == noSymbol) {
+		size_t length;
+		const char* name = this->chars(string, length);
+		symbol = Interner::intern(name, length);
+		this->symbols[string].store(symbol, memory_order_relaxed);
+	}
+	return symbol;
+}
+
+PPToken PrecompiledHeader :: token(const TokenEntry& entry) {
+	return PPToken(Position(entry.line, entry.column), \
+			this->symbol(entry.string), (TokenKey) entry.key);
+}
+
+PPToken PrecompiledHeader :: getToken(size_t index) {
+	return this->token(this->tokens[index]);
+}
+
+string PrecompiledHeader :: getMacroName(size_t index) const {
+	size_t length;
+	const char* name = this->chars(this->macros[index].name, length);
+	return string(name, length);
+}
+
+//! Builds the macro from the file, the first time it is needed
+Macro* PrecompiledHeader :: materialize(const string& name) {
+	size_t low = 0;
+	size_t high = this->macroCount;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		const MacroEntry& entry = this->macros[middle];
+		size_t length;
+		const char* chars = this->chars(entry.name, length);
+		int order = memcmp(chars, name.data(), min(length, name.length()));
+		if (order == 0) {
+			order = length < name.length() ? -1 : length > name.length();
+		}
+		if (order < 0) {
+			low = middle + 1;
+		} else if (order > 0) {
+			high = middle;
+		} else {
+			size_t count = entry.parameterCount + entry.bodyCount;
+			if (entry.tokens > this->source->size() || count > \
+					(this->source->size() - entry.tokens) / sizeof(TokenEntry)) {
+				throw IOException(this->filename + " is corrupt");
+			}
+			const TokenEntry* tokens = (const TokenEntry*) \
+									   (this->data + entry.tokens);
+			list<PPToken> parameters;
+			list<PPToken> body;
+			for (size_t k = 0; k < count; ++k) {
+				(k < entry.parameterCount ? parameters : body).push_back(\
+						this->token(tokens[k]));
+			}
+			if (entry.function) {
+				return new FunctionMacro(name, body, parameters);
+			}
+			return new ObjectMacro(name, body);
+		}
+	}
+	return NULL;
+}
+
+string PrecompiledHeader :: getFile(size_t index) const {
+	size_t length;
+	const char* path = this->chars(this->files[index].path, length);
+	return string(path, length);
+}
+
+string PrecompiledHeader :: getGuard(size_t index) const {
+	size_t length;
+	const char* guard = this->chars(this->files[index].guard, length);
+	return string(guard, length);
+}
+
+bool PrecompiledHeader :: isOnce(size_t index) const {
+	return this->files[index].once != 0;
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+using namespace std;
+
+class Macro;
+class PPToken;
+class MappedFileSource;
+
+//! A header which has been preprocessed once, written to a file to be mapped
+/*! Holds the preprocessed tokens of the header, the macros defined at its end
+ * and the include guards and #pragma once files seen while preprocessing it.
+ * The file only contains offsets, no pointers, and names are kept in a table
+ * of strings which is interned on demand. Macros are sorted by name, so one
+ * is found by a binary search over the mapped file and is only turned into a
+ * Macro the first time it is expanded, see materialize().
+ */
+class PrecompiledHeader {
+	public:
+		//Maps the file, throws IOException if it is not a usable header
+		PrecompiledHeader(const string& filename);
+		~PrecompiledHeader();
+		static void write(const string& filename, const string& header, \
+				const vector<PPToken>& tokens, const map<string, Macro*>& macros, \
+				const map<string, string>& guards, const set<string>& onceFiles);
+		//Use the header at the start of every file preprocessed, --include-pch
+		static void include(const string& filename);
+		static PrecompiledHeader* getIncluded() {return included;}
+		const string& getHeader() const {return header;}
+		size_t getTokenCount() const {return tokenCount;}
+		PPToken getToken(size_t index);
+		size_t getMacroCount() const {return macroCount;}
+		string getMacroName(size_t index) const;
+		Macro* materialize(const string& name); //NULL if it is not defined
+		size_t getFileCount() const {return fileCount;}
+		string getFile(size_t index) const;
+		string getGuard(size_t index) const; //Empty if the file has none
+		bool isOnce(size_t index) const;
+		static const uint32_t version = 1;
+	private:
+		struct Header {
+			char magic[8];
+			uint32_t version;
+			uint32_t header; //The string of the canonical path of the header
+			uint64_t size; //Of the header when it was preprocessed
+			int64_t modified;
+			int64_t modifiedNanoseconds;
+			uint64_t stringCount;
+			uint64_t tokenCount;
+			uint64_t macroCount;
+			uint64_t fileCount;
+			uint64_t strings; //Offset of the table of strings
+			uint64_t tokens;
+			uint64_t macros;
+			uint64_t files;
+			uint64_t chars; //Offset of the characters of the strings
+			uint64_t charCount;
+		};
+		struct StringEntry {
+			uint64_t offset; //From the first character
+			uint64_t length;
+		};
+		struct TokenEntry {
+			uint32_t string;
+			uint32_t key;
+			uint32_t line;
+			uint32_t column;
+		};
+		struct MacroEntry {
+			uint32_t name;
+			uint32_t function; //1 if function-like
+			uint32_t parameterCount;
+			uint32_t bodyCount;
+			uint64_t tokens; //Offset of the parameters, followed by the body
+		};
+		struct FileEntry {
+			uint32_t path;
+			uint32_t guard; //A string of length 0 if there is none
+			uint32_t once;
+			uint32_t unused;
+		};
+		const char* chars(uint32_t string, size_t& length) const;
+		unsigned int symbol(uint32_t string);
+		PPToken token(const TokenEntry& entry);
+		MappedFileSource* source;
+		const char* data;
+		string filename;
+		string header;
+		size_t stringCount;
+		size_t tokenCount;
+		size_t macroCount;
+		size_t fileCount;
+		const StringEntry* strings;
+		const TokenEntry* tokens;
+		const MacroEntry* macros;
+		const FileEntry* files;
+		const char* text; //The characters of all strings
+		size_t textLength;
+		//Of each string, noSymbol until interned, by any of the threads
+		vector<atomic<unsigned int>> symbols;
+		static const unsigned int noSymbol = (unsigned int) -1;
+		static PrecompiledHeader* included;
+};
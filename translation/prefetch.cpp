@@ -0,0 +1,109 @@
+#include "translation.h"
+
+IncludePrefetcher& IncludePrefetcher :: instance() {
+	static IncludePrefetcher prefetcher;
+	return prefetcher;
+}
+
+void IncludePrefetcher :: start(unsigned int threads) {
+	Interner::share();
+	IncludePrefetcher& prefetcher = instance();
+	for (unsigned int k = 0; k < threads; ++k) {
+		prefetcher.threads.push_back(thread(&IncludePrefetcher::work, \
+					&prefetcher));
+	}
+}
+
+void IncludePrefetcher :: stop() {
+	IncludePrefetcher& prefetcher = instance();
+	{
+		lock_guard<mutex> guard(prefetcher.lock);
+		prefetcher.stopping = true;
+	}
+	prefetcher.queued.notify_all();
+	for (thread& worker : prefetcher.threads) {
+		worker.join();
+	}
+	prefetcher.threads.clear();
+}
+
+void IncludePrefetcher :: prefetch(const string& filename) {
+	IncludePrefetcher& prefetcher = instance();
+	if (prefetcher.threads.empty()) {
+		return;
+	}
+	Task task = {"", filename};
+	{
+		lock_guard<mutex> guard(prefetcher.lock);
+		prefetcher.tasks.push_back(task);
+	}
+	prefetcher.queued.notify_one();
+}
+
+void IncludePrefetcher :: work() {
+	while (true) {
+		Task task;
+		{
+			unique_lock<mutex> guard(this->lock);
+			while (!this->stopping && this->tasks.empty()) {
+				this->queued.wait(guard);
+			}
+			if (this->stopping) {
+				return;
+			}
+			task = this->tasks.front();
+			this->tasks.pop_front();
+		}
+		try {
+			this->run(task);
+		} catch (runtime_error& error) {
+			//The preprocessor reports it, if it gets to the #include
+		}
+	}
+}
+
+void IncludePrefetcher :: run(const Task& task) {
+	if (task.name.length() == 0) {
+		//Only the #includes are needed, the main thread lexes all of it
+		LexedFile* file = TokenCache::lexDirectives(task.includer);
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->add(file, task.includer);
+		}
+		delete file;
+		return;
+	}
+	bool quoted = task.name[0] == '\"';
+	string path = IncludeResolver::resolve(\
+			task.name.substr(1, task.name.length() - 2), quoted, task.includer);
+	if (path.length() == 0) {
+		return;
+	}
+	{
+		lock_guard<mutex> guard(this->lock);
+		if (!this->seen.insert('\0' + path).second) {
+			return;
+		}
+	}
+	const LexedFile* file = TokenCache::lookup(path);
+	lock_guard<mutex> guard(this->lock);
+	++this->prefetched;
+	this->add(file, path);
+}
+
+void IncludePrefetcher :: add(const LexedFile* file, const string& filename) {
+	//Only quoted includes depend on where the includer is
+	string directory = filename.substr(0, filename.rfind('/') + 1);
+	size_t added = 0;
+	for (const string& name : file->getIncludes()) {
+		string key = name[0] == '\"' ? directory + name : name;
+		if (this->seen.insert(key).second) {
+			Task task = {name, filename};
+			this->tasks.push_back(task);
+			++added;
+		}
+	}
+	if (added > 0) {
+		this->queued.notify_all();
+	}
+}
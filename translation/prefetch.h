@@ -0,0 +1,55 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+
+class LexedFile;
+
+//! Lexes the headers a file will include before the preprocessor gets to them
+/*! The directive lines of the file are scanned for #includes, see
+ * TokenCache::lexDirectives(), and the headers they name are resolved and
+ * put in the TokenCache by a few threads, as are the headers those include.
+ * Meanwhile the main thread lexes and preprocesses the file, and later finds
+ * its headers already lexed, or waits for the thread which is lexing one.
+ *
+ * This only guesses: #includes in groups which will be skipped are prefetched
+ * as well, and those whose name is made by a macro are not. Errors are left
+ * for the preprocessor to report when it gets to the #include.
+ */
+class IncludePrefetcher {
+	public:
+		//Starts the threads, before any other thread uses the tables
+		static void start(unsigned int threads);
+		//Prefetches the headers of a file which is about to be preprocessed
+		static void prefetch(const string& filename);
+		//Waits for the threads to finish their current task, before returning
+		//from main, as the tables they use are destroyed after that
+		static void stop();
+		static unsigned int getPrefetched() {return instance().prefetched;}
+		//None unless asked for with --prefetch-threads, as the threads cost
+		//more than they save on files with few headers
+		static const unsigned int defaultThreads = 0;
+	private:
+		//A header name to resolve, or the file itself if the name is empty
+		struct Task {
+			string name; //With its quotes or angle brackets
+			string includer;
+		};
+		IncludePrefetcher() : stopping(false), prefetched(0) {}
+		static IncludePrefetcher& instance();
+		void work(); //Run by each thread
+		void run(const Task& task);
+		//Queues the headers the file includes, with the lock held
+		void add(const LexedFile* file, const string& filename);
+		vector<thread> threads;
+		deque<Task> tasks;
+		set<string> seen; //Header names and their includers, and files added
+		mutex lock;
+		condition_variable queued; //Notified when there are tasks or stopping
+		bool stopping;
+		unsigned int prefetched; //Headers put in the TokenCache
+};
@@ -1,171 +1,536 @@
 #include "preprocessing.h"
+#include <cerrno>
+#include <cstring>
 using namespace std;
 
-Preprocessor :: Preprocessor(string filename) : Phase(filename) {
+thread_local map<string, string> Preprocessor :: guardMacros;
+thread_local set<string> Preprocessor :: onceFiles;
+thread_local vector<string> Preprocessor :: includedFiles;
+thread_local set<string> Preprocessor :: notPrecompiled;
+atomic<unsigned int> Preprocessor :: skippedIncludes(0);
+atomic<size_t> Preprocessor :: skippedBytes(0);
+
+Preprocessor :: Preprocessor(string filename, const LexedFile* file, \
+		map<string, Macro*>* macroMap) : Preprocessor(filename, file, \
+			macroMap, replayGuarded(file, macroMap)) {}
+
+Preprocessor :: Preprocessor(string filename, const LexedFile* file, \
+		map<string, Macro*>* macroMap, TokenReplay* replay) : Phase(replay), \
+	replay(replay) {
 	this->filename = filename;
-	this->filestream = ifstream(filename);
-	if (!this->filestream.good()) {
-		throw IOException("Could not open filestream for file " + filename);
-	}
-	this->stream12 = stringstream(std::ios_base::in
-                              | std::ios_base::out
-                              | std::ios_base::app);
-	this->stream23 = stringstream(std::ios_base::in
-                              | std::ios_base::out
-                              | std::ios_base::app);
-	phase1(&filestream, &this->stream12);
-	phase2(&stream12, &this->stream23);
-	this->lexSource = new StreamSource<char>(&this->stream23);
-	this->bufLexSource = new BufferedSource<char>(lexSource);
-	this->lexer = new Lexer(bufLexSource);
+	this->file = file;
+	this->stream = NULL;
 	this->usingCache = false;
-	this->expandingMacro = false;
-	this->macroMap = new map<string, Macro*>();
+	this->includeLine = 0;
+	this->system = false;
+	this->changes = &this->fileChanges;
+	this->collecting = false;
+	this->inDirective = false;
+	this->precompiled = NULL;
+	this->precompiledAt = 0;
+	this->precompiledEnd = 0;
+	this->fromPrecompiled = false;
+	this->macroMap = macroMap;
+	if (file->getGuard().length() > 0) {
+		guardMacros[TokenCache::canonicalPath(filename)] = file->getGuard();
+	}
 }
 
+Preprocessor :: Preprocessor(string filename, TokenStream* stream, \
+		map<string, Macro*>* macroMap) : Preprocessor(filename, stream, \
+			stream != NULL ? stream : TokenCache::lookup(filename), macroMap) {}
+
+Preprocessor :: Preprocessor(string filename, TokenStream* stream, \
+		const LexedFile* file, map<string, Macro*>* macroMap) : \
+	Preprocessor(filename, file, macroMap, stream != NULL ? \
+			new TokenReplay(stream) : replayGuarded(file, macroMap)) {
+	this->stream = stream;
+}
+
+//! Starts with the tokens of the precompiled header, if one is included
+/*! Its macros are not read here, they are looked up in the header when
+ * first needed, see findMacro(). Its include guards and #pragma once files
+ * are remembered as if the header had been included.
+ */
+Preprocessor :: Preprocessor(string filename, bool streamed) : \
+	Preprocessor(filename, streamed && !TokenCache::isDirectivesOnly() ? \
+			new TokenStream(filename) : NULL, new map<string, Macro*>()) {
+	this->precompiled = PrecompiledHeader::getIncluded();
+	if (this->precompiled == NULL) {
+		return;
+	}
+	this->precompiledEnd = this->precompiled->getTokenCount();
+	for (size_t k = 0; k < this->precompiled->getFileCount(); ++k) {
+		string guard = this->precompiled->getGuard(k);
+		if (guard.length() > 0) {
+			guardMacros[TokenCache::canonicalPath( \
+					this->precompiled->getFile(k))] = guard;
+		}
+		if (this->precompiled->isOnce(k)) {
+			onceFiles.insert(TokenCache::canonicalPath( \
+						this->precompiled->getFile(k)));
+		}
+	}
+}
+
+//! The macro with the name, or NULL if it is not defined
+/*! A macro of the precompiled header is built the first time it is looked
+ * up and is then kept in the map like any other. A name which the header
+ * does not define is kept in a set of its own, so that the map does not get
+ * an entry for every identifier of the unit. #undef leaves NULL in the map,
+ * hiding the header.
+ */
+Macro* Preprocessor :: findMacro(map<string, Macro*>* macroMap, \
+		const string& name) {
+	auto search = macroMap->find(name);
+	if (search != macroMap->end()) {
+		return search->second;
+	}
+	PrecompiledHeader* precompiled = PrecompiledHeader::getIncluded();
+	if (precompiled == NULL || notPrecompiled.count(name) > 0) {
+		return NULL;
+	}
+	Macro* macro = precompiled->materialize(name);
+	if (macro == NULL) {
+		notPrecompiled.insert(name);
+	} else {
+		(*macroMap)[name] = macro;
+	}
+	return macro;
+}
+
+//! Writes the tokens of the file and the macros defined at its end
+void Preprocessor :: precompile(const string& outputname) {
+	vector<PPToken> tokens;
+	while (!this->empty()) {
+		tokens.push_back(this->get());
+	}
+	map<string, Macro*> macros;
+	if (this->precompiled != NULL) {
+		for (size_t k = 0; k < this->precompiled->getMacroCount(); ++k) {
+			string name = this->precompiled->getMacroName(k);
+			macros[name] = findMacro(this->macroMap, name);
+		}
+	}
+	for (auto& pair : *this->macroMap) {
+		macros[pair.first] = pair.second;
+	}
+	for (auto it = macros.begin(); it != macros.end(); ) {
+		it = it->second == NULL ? macros.erase(it) : ++it;
+	}
+	PrecompiledHeader::write(outputname, this->filename, tokens, macros, \
+			guardMacros, onceFiles);
+}
+
+TokenReplay* Preprocessor :: replayGuarded(const LexedFile* file, \
+		map<string, Macro*>* macroMap) {
+	const vector<PPToken>* tokens = file->getTokens();
+	if (file->getGuard().length() == 0) {
+		return new TokenReplay(tokens, 0, tokens->size());
+	}
+	if (findMacro(macroMap, file->getGuard()) != NULL) {
+		return new TokenReplay(tokens, 0, 0); //Nothing to preprocess
+	}
+	//Leave out the #ifndef and the #endif, the #define is kept
+	return new TokenReplay(tokens, file->getGuardedBegin(), \
+			file->getGuardedEnd());
+}
+
+//! Returns the next PPToken, with macros expanded
+/*! Macros are expanded lazily: an invocation pushes an Expansion, which is a
+ * cursor into the ops of the macro, and its tokens are read through next()
+ * and rescanned in expand() like any other. A name is not expanded again
+ * while it is in the hide set of the token, so recursion stops as in C11
+ * 6.10.3.4. Arguments are expanded before they are substituted, see
+ * expandArguments().
+ */
 PPToken Preprocessor :: get() {
-	if (this->expandingMacro) {
-		if (!this->macroCache->empty()) {
-			PPToken ret = this->macroCache->front();
-			this->macroCache->pop_front();
-			if (this->macroCache->empty() ){
-					this->expandingMacro = false;
+	if (this->precompiledAt < this->precompiledEnd) {
+		//Already preprocessed
+		if (this->precompiledAt == 0) {
+			FileChange change = {true, this->precompiled->getHeader(), 1, false};
+			this->changes->push_back(change);
+		}
+		this->fromPrecompiled = true;
+		return this->precompiled->getToken(this->precompiledAt++);
+	}
+	if (this->fromPrecompiled) {
+		FileChange change = {false, this->filename, 1, false};
+		this->changes->push_back(change);
+		this->fromPrecompiled = false;
+	}
+	PPToken token;
+	unsigned int hidden;
+	this->expand(token, hidden);
+	return token;
+}
+
+//! The next token with macros expanded, and its hide set
+/*! False if an argument being expanded ran out of tokens first, e.g. if it
+ * ended with a macro which expands to nothing.
+ */
+bool Preprocessor :: expand(PPToken& token, unsigned int& hidden) {
+	while (true) {
+		if (!this->isolations.empty() && this->exhausted()) {
+			return false;
+		}
+		token = this->next(hidden);
+		if (token.getKey() != IDENTIFIER || \
+				HideSet::contains(hidden, token.getSymbol())) {
+			return true;
+		}
+		Macro* macro = findMacro(this->macroMap, token.getName());
+		if (macro == NULL) {
+			return true;
+		}
+		//Do dynamic down-cast to FunctionMacro if possible, it is only expanded
+		//if it is invoked
+		if (FunctionMacro* fm = dynamic_cast<FunctionMacro*>(macro)) {
+			if (!this->invoke(fm, token, hidden)) {
+				return true;
 			}
-			return ret;
 		} else {
-			//Done with this macro
-			this->expandingMacro = false;
+			Expansion expansion = {macro, 0, 0, 0, \
+				HideSet::add(hidden, token.getSymbol()), this->arguments.size(), \
+				0, this->arena.size(), token.getPosition()};
+			this->expansions.push_back(expansion);
+			this->settle();
 		}
 	}
-	PPToken token = this->unexpandedGet();
-	if (token.getKey() == IDENTIFIER) {
-		auto search = this->macroMap->find(token.getName());
-		if (search != this->macroMap->end()) {
-			//Do dynamic down-cast to FunctionMacro if possible and expect function-like 
-			//macro whenever it works
-			if (FunctionMacro* fm = dynamic_cast<FunctionMacro*>(search->second)) {
-				token = this->unexpandedGet();
-				if (token.getName() != "(") {
-					string err = "Expected '(' after invocation of function-like macro ";
-					err += search->first;
-					throw SyntaxException(err);
-				} else {
-					unsigned int parenDepth = 1; //Keep track of how many layers of 
-					//parenthesis deep we curently are
-					list<PPToken>* currentList = new list<PPToken>();
-					token = this->unexpandedGet();
-					while (parenDepth > 0) {
-						if (token.getName() == ")") {
-							--parenDepth;
-							if (parenDepth == 0) {
-								break;
-							}
-						} else if (token.getName() == "(") {
-							++parenDepth;
-						} else if (token.getName() == "," && parenDepth == 1) {
-							if (!fm->bind(currentList)) {
-								string err = "Could not bind argument to function-like"\
-											  " macro";
-								throw SyntaxException(err);
-							}
-							currentList = new list<PPToken>();
-						} else if (token.getName() == "\n" && parenDepth != 0) {
-							string err = "Expected ')' before new line";
-							throw SyntaxException(err);
-						} else {
-							currentList->push_back(token);
-						}
-						token = this->unexpandedGet();
-					}
-					//Do not check for errors here, as it might be 
-					//a 0 argument macro
-					fm->bind(currentList);
-					this->macroCache = new list<PPToken>(fm->expand());
-					this->expandingMacro = true;
-					this->bufLexSource->trim(1);
-					this->bufLexSource->reset();
-					return PPToken(this->getPosition(), "", WHITESPACE);
-				}
+}
+
+//! The next token and its hide set, not expanded
+/*! Tokens put back come first, then those of the innermost expansion and
+ * last the tokens of the file.
+ */
+PPToken Preprocessor :: next(unsigned int& hidden) {
+	size_t pendingBase = 0;
+	size_t expansionBase = 0;
+	if (!this->isolations.empty()) {
+		pendingBase = this->isolations.back().pending;
+		expansionBase = this->isolations.back().expansions;
+	}
+	if (this->pending.size() > pendingBase) {
+		PPToken token = this->pending.back();
+		hidden = this->pendingHidden.back();
+		this->pending.pop_back();
+		this->pendingHidden.pop_back();
+		return token;
+	}
+	if (this->expansions.size() > expansionBase) {
+		Expansion& top = this->expansions.back();
+		PPToken token;
+		if (top.argAt < top.argEnd) {
+			token = this->arena[top.argAt];
+			hidden = this->arenaHidden[top.argAt];
+			++top.argAt;
+		} else {
+			const MacroOp& op = top.macro->getOps()[top.op];
+			//Tokens of the body are placed where the macro was invoked
+			if (op.isParameter()) {
+				//Nothing was bound to the parameter, leave its name
+				token = top.macro->getParameter(op.getIndex());
+			} else {
+				token = top.macro->getToken(op.getIndex());
 			}
-			//Found something, start returning expanded version
-			this->macroCache = new list<PPToken>(search->second->expand());
-			this->expandingMacro = true;
-			return this->get();
+			token = PPToken(top.position, token.getSymbol(), token.getKey());
+			hidden = top.hidden;
+			++top.op;
 		}
+		this->settle();
+		return token;
+	}
+	if (!this->isolations.empty()) {
+		Isolation& isolation = this->isolations.back();
+		hidden = this->arenaHidden[isolation.at];
+		return this->arena[isolation.at++];
+	}
+	hidden = 0;
+	return this->unexpandedGet();
+}
+
+bool Preprocessor :: exhausted() {
+	if (this->isolations.empty()) {
+		return this->empty();
+	}
+	const Isolation& isolation = this->isolations.back();
+	return this->pending.size() == isolation.pending && \
+		this->expansions.size() == isolation.expansions && \
+		isolation.at == isolation.end;
+}
+
+//! Moves the innermost expansion to its next token, dropping finished ones
+/*! Expansions begun outside of the argument being expanded are left alone.
+ */
+void Preprocessor :: settle() {
+	size_t base = this->isolations.empty() ? 0 : \
+				  this->isolations.back().expansions;
+	while (this->expansions.size() > base) {
+		Expansion& top = this->expansions.back();
+		if (top.argAt < top.argEnd) {
+			return;
+		}
+		const vector<MacroOp>& ops = top.macro->getOps();
+		if (top.op == ops.size()) {
+			//Its arguments are last in the arena, unless an invocation is being
+			//collected after them
+			if (!this->collecting) {
+				this->arena.resize(top.arena);
+				this->arenaHidden.resize(top.arena);
+				this->arguments.erase(this->arguments.begin() + top.arguments, \
+						this->arguments.end());
+			}
+			this->expansions.pop_back();
+			continue;
+		}
+		const MacroOp& op = ops[top.op];
+		if (!op.isParameter() || op.getIndex() >= top.argumentCount) {
+			return;
+		}
+		const TokenSpan& span = this->arguments[top.arguments + op.getIndex()];
+		top.argAt = span.getBegin();
+		top.argEnd = span.getEnd();
+		++top.op;
+	}
+	if (this->expansions.empty() && this->isolations.empty() && \
+			!this->collecting) {
+		this->arena.clear();
+		this->arenaHidden.clear();
+		this->arguments.clear();
 	}
-	return token;
+}
+
+//! Starts expanding a function-like macro, if its name is followed by '('
+/*! The arguments are collected into the arena without being expanded. If
+ * there is no '(' the tokens looked at are put back and false is returned.
+ */
+bool Preprocessor :: invoke(const FunctionMacro* macro, const PPToken& name, \
+		unsigned int hidden) {
+	unsigned int parenHidden = 0;
+	PPToken token;
+	//Reading on may reach a directive, whose line may invoke macros of its own,
+	//so only the end of the lookahead vectors is used here
+	size_t looked = this->lookahead.size();
+	do {
+		if (this->exhausted() || \
+				(this->inDirective && token.getSymbol() == SYM_NEWLINE)) {
+			break;
+		}
+		token = this->next(parenHidden);
+		this->lookahead.push_back(token);
+		this->lookaheadHidden.push_back(parenHidden);
+	} while (token.getKey() == WHITESPACE);
+	if (this->lookahead.size() == looked || token.getSymbol() != SYM_LPAREN) {
+		//Not an invocation, the name is just a name
+		this->pending.insert(this->pending.end(), this->lookahead.rbegin(), \
+				this->lookahead.rend() - looked);
+		this->pendingHidden.insert(this->pendingHidden.end(), \
+				this->lookaheadHidden.rbegin(), \
+				this->lookaheadHidden.rend() - looked);
+		this->lookahead.resize(looked);
+		this->lookaheadHidden.resize(looked);
+		return false;
+	}
+	this->lookahead.resize(looked);
+	this->lookaheadHidden.resize(looked);
+	bool wasCollecting = this->collecting;
+	this->collecting = true;
+	size_t firstArgument = this->arguments.size();
+	size_t arenaSize = this->arena.size();
+	size_t begin = arenaSize;
+	unsigned int parenDepth = 1; //Keep track of how many layers of 
+	//parenthesis deep we curently are
+	while (true) {
+		if (this->exhausted()) {
+			string err = "Expected ')' before end of file in invocation of macro ";
+			err += name.getName();
+			throw SyntaxException(err);
+		}
+		token = this->next(parenHidden);
+		if (token.getSymbol() == SYM_RPAREN) {
+			--parenDepth;
+			if (parenDepth == 0) {
+				break;
+			}
+		} else if (token.getSymbol() == SYM_LPAREN) {
+			++parenDepth;
+		} else if (token.getSymbol() == SYM_NEWLINE && this->inDirective) {
+			string err = "Expected ')' before new line";
+			throw SyntaxException(err);
+		} else if (token.getSymbol() == SYM_COMMA && parenDepth == 1) {
+			if (this->arguments.size() - firstArgument >= \
+					macro->getParameterCount()) {
+				string err = "Could not bind argument to function-like macro ";
+				err += name.getName();
+				throw SyntaxException(err);
+			}
+			this->arguments.push_back(TokenSpan(begin, this->arena.size()));
+			begin = this->arena.size();
+			continue;
+		}
+		//New lines in the arguments are just white-space
+		this->arena.push_back(token);
+		this->arenaHidden.push_back(parenHidden);
+	}
+	//A macro without parameters is invoked with one empty argument
+	if (this->arguments.size() - firstArgument < macro->getParameterCount()) {
+		this->arguments.push_back(TokenSpan(begin, this->arena.size()));
+	}
+	this->collecting = wasCollecting;
+	hidden = HideSet::add(HideSet::intersect(hidden, parenHidden), \
+			name.getSymbol());
+	this->expandArguments(firstArgument, arenaSize, hidden);
+	Expansion expansion = {macro, 0, 0, 0, hidden, firstArgument, \
+		this->arguments.size() - firstArgument, arenaSize, name.getPosition()};
+	this->expansions.push_back(expansion);
+	this->settle();
+	return true;
+}
+
+//! Replaces the arguments from first on by their expansions
+/*! Each argument is expanded on its own, as if it were all that was left of
+ * the file (C11 6.10.3.1), so an invocation in it has to end in it. The
+ * tokens which are substituted get the hide set of the invocation as well as
+ * their own, so that a name the expansion leaves is not expanded again when
+ * it is rescanned together with the body, e.g. the second 'f' of 'f(f)'
+ * with '#define f(a) a(1)'.
+ */
+void Preprocessor :: expandArguments(size_t first, size_t arena, \
+		unsigned int hidden) {
+	//Mostly no token of the arguments names a macro, and they are their own
+	//expansions
+	bool expandable = false;
+	for (size_t k = arena; k < this->arena.size() && !expandable; ++k) {
+		const PPToken& token = this->arena[k];
+		expandable = token.getKey() == IDENTIFIER && \
+			!HideSet::contains(this->arenaHidden[k], token.getSymbol()) && \
+			findMacro(this->macroMap, token.getName()) != NULL;
+	}
+	if (!expandable) {
+		for (size_t k = arena; k < this->arenaHidden.size(); ++k) {
+			this->arenaHidden[k] = HideSet::unite(this->arenaHidden[k], hidden);
+		}
+		return;
+	}
+	//Invocations in the arguments expand theirs after these, and are done
+	//before these are substituted
+	size_t base = this->expanded.size();
+	size_t end = this->arguments.size();
+	for (size_t k = first; k < end; ++k) {
+		Isolation isolation = {this->arguments[k].getBegin(), \
+			this->arguments[k].getEnd(), this->expansions.size(), \
+			this->pending.size()};
+		this->isolations.push_back(isolation);
+		size_t begin = this->expanded.size();
+		PPToken token;
+		unsigned int tokenHidden;
+		while (this->expand(token, tokenHidden)) {
+			this->expanded.push_back(token);
+			this->expandedHidden.push_back(HideSet::unite(tokenHidden, hidden));
+		}
+		this->isolations.pop_back();
+		this->arguments[k] = TokenSpan(arena + begin - base, \
+				arena + this->expanded.size() - base);
+	}
+	//What the invocations in the arguments collected is no longer needed
+	this->arguments.erase(this->arguments.begin() + end, this->arguments.end());
+	this->arena.resize(arena);
+	this->arenaHidden.resize(arena);
+	this->arena.insert(this->arena.end(), this->expanded.begin() + base, \
+			this->expanded.end());
+	this->arenaHidden.insert(this->arenaHidden.end(), \
+			this->expandedHidden.begin() + base, this->expandedHidden.end());
+	this->expanded.resize(base);
+	this->expandedHidden.resize(base);
 }
 
 //! Returns the next PPToken without expanding macros
 PPToken Preprocessor :: unexpandedGet() {
 	if (this->usingCache) {
 		if (!this->cache->empty()) {
-		return this->cache->get();
+			return this->cache->unexpandedGet();
 		} else {
 			//Done with this cache, continue in normal file
 			this->usingCache = false;
+			FileChange change = {false, this->filename, this->includeLine + 1, \
+				this->system};
+			this->changes->push_back(change);
 			//delete cache;
 		}
 	}
 
-	PPToken first = lexer->get();
-	bufLexSource->trim(1);
-	bufLexSource->reset();
-	if (first.getName() == "#") {
-		PPToken current = lexer->get();
-		bufLexSource->trim(1);
-		bufLexSource->reset();
-		if (current.getName() == "include") {
-			return this->include();	
-		} else if (current.getName() == "define") {
-			return this->define();
-		} else if (current.getName() == "undef") {
-			return this->undef();
+	size_t hash = replay->position();
+	PPToken first = replay->peek();
+	replay->advance();
+	if (first.getSymbol() == SYM_HASH) {
+		PPToken current = replay->peek();
+		replay->advance();
+		while (current.getKey() == WHITESPACE && \
+				current.getSymbol() != SYM_NEWLINE) {
+			current = replay->peek(); //As in '# define'
+			replay->advance();
+		}
+		switch (current.getSymbol()) {
+			case SYM_INCLUDE:
+				return this->include();
+			case SYM_DEFINE:
+				return this->define();
+			case SYM_UNDEF:
+				return this->undef();
+			case SYM_PRAGMA:
+				return this->pragma();
+			case SYM_IF:
+			case SYM_IFDEF:
+			case SYM_IFNDEF:
+				return this->ifGroup(current.getSymbol(), hash);
+			case SYM_ELIF:
+			case SYM_ELSE:
+				return this->elseGroup(current.getSymbol(), hash);
+			case SYM_ENDIF:
+				return this->endif();
 		}
+		replay->seek(hash + 1); //Not a directive, keep what followed the '#'
 	}
 	
-	this->bufLexSource->trim(1);
-	this->bufLexSource->reset();
+	replay->advance();
 	return first;
 }
 
 PPToken Preprocessor :: define() {
-	PPToken token = lexer->get();
-	bufLexSource->trim(1);
-	bufLexSource->reset();
-	while (token.getKey() == WHITESPACE && token.getName() != "\n") {
-		token = lexer->get();
-		bufLexSource->trim(1);
-		bufLexSource->reset();
+	PPToken token = replay->peek();
+	replay->advance();
+	while (token.getKey() == WHITESPACE && token.getSymbol() != SYM_NEWLINE) {
+		token = replay->peek();
+		replay->advance();
 	}
 	if (token.getKey() == IDENTIFIER) {
 		//We have a macro, start setting up for adding it to the macroMap
 		string macroName = token.getName();
-		PPToken current = lexer->get();
-		list<PPToken>* body = new list<PPToken>();
-		if (current.getName() == "(") {
+		PPToken current = replay->peek();
+		list<PPToken> body;
+		if (current.getSymbol() == SYM_LPAREN) {
 			//Function macro
-			bufLexSource->trim(1);
-			bufLexSource->reset();
-			list<PPToken>* args = new list<PPToken>();
-			current = lexer->get();
-			bufLexSource->trim(1);
-			bufLexSource->reset();
+			replay->advance();
+			list<PPToken> args;
+			current = replay->peek();
+			replay->advance();
 			bool delimited = true;
-			while (current.getName() != "\n" || current.getName() != ")") {
+			while (current.getSymbol() != SYM_NEWLINE || \
+					current.getSymbol() != SYM_RPAREN) {
 				if (current.getKey() == IDENTIFIER) {
-					args->push_back(current);
+					args.push_back(current);
 					delimited = false;
-				} else if (current.getName() == ")") {
+				} else if (current.getSymbol() == SYM_RPAREN) {
 					if (delimited) {
 						string err = "Expected name of an argument before closing "\
 									  "parenthesis in definition of function-like macro";
 						throw SyntaxException(err);
 					} else {
-						current = lexer->get();
+						current = replay->peek();
+						replay->advance();
 						break;
 					}
-				} else if (current.getName() == ",") {
+				} else if (current.getSymbol() == SYM_COMMA) {
 					if (delimited) {
 						string err = "Expected name of an argument in definition of "\
 									  "function-like macro";
@@ -173,36 +538,31 @@ PPToken Preprocessor :: define() {
 					} else {
 						delimited = true;
 					}
-				} else if (current.getName() == "\n") {
+				} else if (current.getSymbol() == SYM_NEWLINE) {
 					string err = "Expected end of list of arguments before new line in "\
 								  "declaration of function-like macro";
 				}
-				current = lexer->get();
-				bufLexSource->trim(1);
-				bufLexSource->reset();
+				current = replay->peek();
+				replay->advance();
 			}
-			list<PPToken>* body = new list<PPToken>();
-			while (current.getName() != "\n") {
-				body->push_back(current);
-				current = lexer->get();
-				bufLexSource->trim(1);
-				bufLexSource->reset();
+			while (current.getSymbol() != SYM_NEWLINE) {
+				body.push_back(current);
+				current = replay->peek();
+				replay->advance();
 			}
-			FunctionMacro* macro = new FunctionMacro(macroName, *body, *args);
+			FunctionMacro* macro = new FunctionMacro(macroName, body, args);
 			(*this->macroMap)[macroName] = macro;
 			return current;
 		} else {
 			//Object macro
-			current = lexer->get();
-			bufLexSource->trim(1);
-			bufLexSource->reset();
-			while (current.getName() != "\n") {
-				body->push_back(current);
-				current = lexer->get();
-				bufLexSource->trim(1);
-				bufLexSource->reset();
+			current = replay->peek();
+			replay->advance();
+			while (current.getSymbol() != SYM_NEWLINE) {
+				body.push_back(current);
+				current = replay->peek();
+				replay->advance();
 			}
-			ObjectMacro* macro = new ObjectMacro(macroName, *body);
+			ObjectMacro* macro = new ObjectMacro(macroName, body);
 			(*this->macroMap)[macroName] = macro;
 			return current;
 		}
@@ -211,66 +571,849 @@ PPToken Preprocessor :: define() {
 }
 
 PPToken Preprocessor :: include() {
-	PPToken current = lexer->get();
-	bufLexSource->trim(1);
-	bufLexSource->reset();
+	PPToken current = replay->peek();
+	replay->advance();
 	while( current.getKey() == WHITESPACE && \
-			current.getName() != "\n") { //Skip whitespace tokens
-		current = lexer->get();
-		bufLexSource->reset();
+			current.getSymbol() != SYM_NEWLINE) { //Skip whitespace tokens
+		replay->advance();
+		current = replay->peek();
 	}
-	PPToken headerfileToken = lexer->matchHeaderName();
+	PPTokenInternal headerfileToken = replay->matchHeaderName();
 	string headerfile = headerfileToken.getName();
-	string filename;
 	//If headername matched, it has a name of length > 0
 	if (headerfile.length() > 0) {
-		if (headerfile.substr(0,1) == "<") {
-			filename += "/usr/include/"; //OS X 10.9
-		} else {
-			char* cwdBuf = NULL;
-			cwdBuf = getcwd(cwdBuf, 0);
-			filename += cwdBuf;
-			filename += "/";
-			free(cwdBuf);
-		}
+		bool quoted = headerfile[0] == '\"';
 		headerfile.pop_back();
 		headerfile.erase(0,1); //Remove first char
-		filename += headerfile;
-		bufLexSource->clear();
+		string filename = IncludeResolver::resolve(headerfile, quoted, \
+				this->filename);
+		if (filename.length() == 0) {
+			throw IOException("Could not find " + headerfile + \
+					" while in " + this->filename);
+		}
+		includedFiles.push_back(filename);
+		//Files which would turn out empty are not even looked up
+		string path = TokenCache::canonicalPath(filename);
+		auto guard = guardMacros.find(path);
+		if (onceFiles.count(path) > 0 || (guard != guardMacros.end() && \
+					findMacro(this->macroMap, guard->second) != NULL)) {
+			++skippedIncludes;
+			return PPToken(this->getPosition(), "", OTHER);
+		}
 		//Now, set up a new Preprocessor for the included file as 'cache'
 		//in the current preprocessor.
 		try {
-			this->cache = new Preprocessor(filename);
+			this->cache = new Preprocessor(filename, \
+					TokenCache::lookup(filename), this->macroMap);
 		} catch (IOException error) {
 			throw IOException("Could not create preprocessor for " + \
 					filename + " while in " + this->filename);
 		}
 		this->usingCache = true;
+		this->includeLine = current.getLine();
+		this->cache->changes = this->changes;
+		this->cache->system = IncludeResolver::isSystem(filename);
+		FileChange change = {true, filename, 1, this->cache->system};
+		this->changes->push_back(change);
 		if (!this->cache->empty()) {
-			return this->cache->get();
+			return this->cache->unexpandedGet();
 		}
 	}
 	return PPToken(this->getPosition(), "", OTHER);
 }
 
 PPToken Preprocessor :: undef() {
-	PPToken current = lexer->get();
-	while (current.getKey() == WHITESPACE && current.getName() != "\n") {
-		current = lexer->get();
-		bufLexSource->trim(1);
-		bufLexSource->reset();
+	PPToken current = replay->peek();
+	while (current.getKey() == WHITESPACE && \
+			current.getSymbol() != SYM_NEWLINE) {
+		current = replay->peek();
+		replay->advance();
 	}
-	if (current.getName() == "\n") {
+	if (current.getSymbol() == SYM_NEWLINE) {
 		string err = "Expected macro name to undef before new line";
 		throw SyntaxException(err);
 	} else if (current.getKey() != IDENTIFIER) {
 		string err = "Expected identifier to apply undef to";
 		throw SyntaxException(err);
 	} else {
-		macroMap->erase(current.getName());
+		(*this->macroMap)[current.getName()] = NULL;
+	}
+	replay->advance();
+	return this->skipLine();
+}
+
+
+//! Handles #pragma once, other pragmas are ignored
+PPToken Preprocessor :: pragma() {
+	PPToken current = replay->peek();
+	replay->advance();
+	while (current.getKey() == WHITESPACE && \
+			current.getSymbol() != SYM_NEWLINE) {
+		current = replay->peek();
+		replay->advance();
+	}
+	if (current.getSymbol() == SYM_ONCE) {
+		onceFiles.insert(TokenCache::canonicalPath(this->filename));
+	}
+	if (current.getSymbol() == SYM_NEWLINE) {
+		return current;
+	}
+	return this->skipLine();
+}
+
+//! Skips the rest of the line, and returns the new-line like define() does
+PPToken Preprocessor :: skipLine() {
+	PPToken current = replay->peek();
+	replay->advance();
+	while (current.getSymbol() != SYM_NEWLINE && !replay->empty()) {
+		current = replay->peek();
+		replay->advance();
+	}
+	return current;
+}
+
+//! Handles #if, #ifdef and #ifndef
+PPToken Preprocessor :: ifGroup(unsigned int kind, size_t hash) {
+	PPToken newline;
+	if (this->condition(kind, newline)) {
+		this->groups.push_back(false);
+		return newline;
+	}
+	return this->skipGroup(hash, false);
+}
+
+//! Handles #elif and #else, met at the end of the group being read
+PPToken Preprocessor :: elseGroup(unsigned int kind, size_t hash) {
+	if (this->groups.empty()) {
+		string err = "#" + Interner::lookup(kind) + " without #if";
+		throw SyntaxException(err);
+	} else if (this->groups.back()) {
+		string err = "#" + Interner::lookup(kind) + " after #else";
+		throw SyntaxException(err);
+	}
+	this->groups.back() = kind == SYM_ELSE;
+	return this->skipGroup(hash, true);
+}
+
+PPToken Preprocessor :: endif() {
+	if (this->groups.empty()) {
+		string err = "#endif without #if";
+		throw SyntaxException(err);
+	}
+	this->groups.pop_back();
+	return this->skipLine();
+}
+
+//! Skips groups which are not to be preprocessed
+/*! Skipping starts after the directive whose '#' is at hash. If no group of
+ * the #if has been taken, the first #elif whose condition holds or the #else
+ * starts the group to read. Otherwise the skipping goes on to the #endif.
+ * Only the conditionals indexed by the LexedFile are looked at, so the tokens
+ * of the skipped groups are never read. A streamed file is lexed on until
+ * the conditional looked for is found, dropping the tokens of the groups.
+ */
+PPToken Preprocessor :: skipGroup(size_t hash, bool taken) {
+	const vector<Conditional>& conditionals = this->file->getConditionals();
+	auto before = [](const Conditional& c, size_t at) {return c.getAt() < at;};
+	auto from = lower_bound(conditionals.begin(), conditionals.end(), hash, \
+			before);
+	size_t fromOffset = from == conditionals.end() ? 0 : from->getOffset();
+	size_t at = replay->position(); //Conditionals before it have been seen
+	unsigned int depth = 0; //Of #ifs inside the skipped groups
+	bool sawElse = taken && this->groups.back();
+	while (true) {
+		//A streamed file is lexed on until it has the next conditional
+		auto c = lower_bound(conditionals.begin(), conditionals.end(), at, \
+				before);
+		if (c == conditionals.end() || c->getAt() >= replay->getEnd()) {
+			replay->seek(replay->getEnd()); //What is lexed on is skipped
+			if (replay->more()) {
+				continue;
+			}
+			break;
+		}
+		at = c->getAt() + 1;
+		Conditional::Kind kind = c->getKind();
+		size_t offset = c->getOffset();
+		if (kind == Conditional::IF || kind == Conditional::IFDEF || \
+				kind == Conditional::IFNDEF) {
+			++depth;
+			continue;
+		} else if (depth > 0) {
+			if (kind == Conditional::ENDIF) {
+				--depth;
+			}
+			continue;
+		} else if (kind != Conditional::ENDIF) {
+			if (sawElse) {
+				string err = kind == Conditional::ELSE ? "#else after #else" : \
+							 "#elif after #else";
+				throw SyntaxException(err);
+			}
+			sawElse = kind == Conditional::ELSE;
+			if (taken) {
+				continue;
+			}
+		}
+		skippedBytes += offset - fromOffset;
+		replay->seek(c->getAfter());
+		if (kind == Conditional::ENDIF) {
+			if (taken) {
+				this->groups.pop_back();
+			}
+			return this->skipLine();
+		} else if (kind == Conditional::ELSE) {
+			this->groups.push_back(true);
+			return this->skipLine();
+		}
+		PPToken newline;
+		if (this->condition(SYM_ELIF, newline)) {
+			this->groups.push_back(false);
+			return newline;
+		}
+		fromOffset = offset; //The line may have been lexed on, moving c
+	}
+	string err = "Unterminated conditional directive in " + this->filename;
+	throw SyntaxException(err);
+}
+
+//! Reads the rest of an #if, #ifdef, #ifndef or #elif line and evaluates it
+/*! For #if and #elif the defined operators are replaced first, then the
+ * macros of the line are expanded by reading it through get() in place of the
+ * file.
+ */
+bool Preprocessor :: condition(unsigned int kind, PPToken& newline) {
+	vector<PPToken> line;
+	newline = replay->peek();
+	replay->advance();
+	while (newline.getSymbol() != SYM_NEWLINE && !replay->empty()) {
+		line.push_back(newline);
+		newline = replay->peek();
+		replay->advance();
+	}
+	if (kind == SYM_IFDEF || kind == SYM_IFNDEF) {
+		for (const PPToken& token : line) {
+			if (token.getKey() == IDENTIFIER) {
+				bool defined = findMacro(this->macroMap, token.getName()) != NULL;
+				return defined == (kind == SYM_IFDEF);
+			} else if (token.getKey() != WHITESPACE) {
+				break;
+			}
+		}
+		string err = "Expected macro name after #" + Interner::lookup(kind);
+		throw SyntaxException(err);
+	}
+	vector<PPToken> expression;
+	for (size_t i = 0; i < line.size(); ++i) {
+		if (line[i].getSymbol() != SYM_DEFINED) {
+			expression.push_back(line[i]);
+			continue;
+		}
+		size_t at = i + 1;
+		while (at < line.size() && line[at].getKey() == WHITESPACE) {
+			++at;
+		}
+		bool paren = at < line.size() && line[at].getSymbol() == SYM_LPAREN;
+		if (paren) {
+			do {
+				++at;
+			} while (at < line.size() && line[at].getKey() == WHITESPACE);
+		}
+		if (at >= line.size() || line[at].getKey() != IDENTIFIER) {
+			string err = "Expected macro name after defined";
+			throw SyntaxException(err);
+		}
+		bool defined = findMacro(this->macroMap, line[at].getName()) != NULL;
+		if (paren) {
+			do {
+				++at;
+			} while (at < line.size() && line[at].getKey() == WHITESPACE);
+			if (at >= line.size() || line[at].getSymbol() != SYM_RPAREN) {
+				string err = "Expected ')' after defined";
+				throw SyntaxException(err);
+			}
+		}
+		expression.push_back(PPToken(line[i].getPosition(), \
+					defined ? "1" : "0", PPNUMBER));
+		i = at;
+	}
+	expression.push_back(PPToken(newline.getPosition(), "\n", WHITESPACE));
+	TokenReplay directive(&expression, 0, expression.size());
+	TokenReplay* file = this->replay;
+	bool wasInDirective = this->inDirective;
+	this->replay = &directive;
+	this->inDirective = true;
+	line.clear();
+	try {
+		PPToken token = this->get();
+		while (token.getSymbol() != SYM_NEWLINE) {
+			line.push_back(token);
+			token = this->get();
+		}
+	} catch (...) {
+		this->replay = file;
+		this->inDirective = wasInDirective;
+		throw;
+	}
+	this->replay = file;
+	this->inDirective = wasInDirective;
+	return PPExpression::evaluate(line);
+}
+
+PPToken TokenReplay :: peek() {
+	if (this->next >= this->end && !this->more()) {
+		//Past the end the lexer only finds the null character
+		this->lexed = this->next + 1;
+		return PPToken(Position(), SYM_NUL, OTHER);
+	}
+	if (this->lexed <= this->next) {
+		this->lexed = this->next + 1;
+	}
+	return (*this->tokens)[this->next - this->base];
+}
+
+//! Matches a header name made of the tokens from the next one on
+/*! On a match, the tokens of the header name and the token after it are
+ * moved past, otherwise nothing is.
+ */
+PPTokenInternal TokenReplay :: matchHeaderName() {
+	string name = "";
+	PPToken current = this->peek();
+	if (current.getSymbol() == SYM_LESS || current.getSymbol() == SYM_QUOTE) {
+		string end = ">";
+		if (current.getSymbol() == SYM_QUOTE) {
+			end = "\"";
+		}
+		name += current.getName();
+		size_t at = this->next + 1;
+		while (at < this->end || this->more()) {
+			const string& part = (*this->tokens)[at - this->base].getName();
+			if (part == end) {
+				name += part;
+				//Skip the header name and what follows it, usually a new-line.
+				//Only the first character of that was read by the old lexer,
+				//so it does not count as peeked.
+				this->next = at + 2;
+				if (this->lexed < at + 1) {
+					this->lexed = at + 1;
+				}
+				return PPTokenInternal(Position(), name, HEADERNAME);
+			}
+			for (char c : part) {
+				if (!isBaseChar(c) || c == '\n') {
+					return PPTokenInternal(Position(), "", OTHER);
+				}
+			}
+			name += part;
+			++at;
+		}
+		return PPTokenInternal(Position(), "", OTHER);
+	}
+	return PPTokenInternal(Position(), name, HEADERNAME);
+}
+
+TokenCache& TokenCache :: instance() {
+	static TokenCache cache;
+	return cache;
+}
+
+const LexedFile* TokenCache :: lookup(const string& filename) {
+	struct stat info;
+	string path = canonicalPath(filename);
+	if (path.length() == 0 || stat(path.c_str(), &info) != 0) {
+		throw IOException("Could not open filestream for file " + filename);
+	}
+	TokenCache& cache = instance();
+	unique_lock<mutex> guard(cache.lock);
+	auto search = cache.entries.find(path);
+	while (search != cache.entries.end() && search->second.file == NULL) {
+		//Being lexed by another thread, see IncludePrefetcher
+		cache.lexed.wait(guard);
+		search = cache.entries.find(path);
+	}
+	if (search != cache.entries.end()) {
+		Entry& entry = search->second;
+		if (entry.modified == info.st_mtim.tv_sec && \
+				entry.modifiedNanoseconds == info.st_mtim.tv_nsec && \
+				entry.size == info.st_size) {
+			++cache.hits;
+			return entry.file;
+		}
+		//The file has changed since it was lexed. Preprocessors replaying the
+		//old tokens may still be around, so they are not deleted.
+	}
+	++cache.misses;
+	Entry entry;
+	entry.modified = info.st_mtim.tv_sec;
+	entry.modifiedNanoseconds = info.st_mtim.tv_nsec;
+	entry.size = info.st_size;
+	entry.file = NULL;
+	cache.entries[path] = entry;
+	//Other files can be looked up while this one is lexed
+	guard.unlock();
+	LexedFile* file;
+	try {
+		file = cache.directivesOnly ? lexDirectives(path) : lex(path);
+	} catch (...) {
+		guard.lock();
+		cache.entries.erase(path);
+		cache.lexed.notify_all();
+		throw;
+	}
+	guard.lock();
+	cache.entries[path].file = file;
+	cache.lexed.notify_all();
+	return file;
+}
+
+string TokenCache :: canonicalPath(const string& filename) {
+	TokenCache& cache = instance();
+	{
+		lock_guard<mutex> guard(cache.lock);
+		auto search = cache.paths.find(filename);
+		if (search != cache.paths.end()) {
+			return search->second;
+		}
+	}
+	char* canonical = realpath(filename.c_str(), NULL);
+	if (canonical == NULL) {
+		return ""; //Not kept, the file may yet be made
+	}
+	string path = canonical;
+	free(canonical);
+	lock_guard<mutex> guard(cache.lock);
+	cache.paths[filename] = path;
+	return path;
+}
+
+//! Performs translation phases 1 to 3 on the whole file
+LexedFile* TokenCache :: lex(const string& filename) {
+	MappedFileSource file(filename);
+	LineSplicer splicer(&file);
+	BufferedSource<char> buffer(&splicer);
+	Lexer lexer(&buffer, &splicer.getSplices());
+	vector<PPToken>* tokens = new vector<PPToken>();
+	tokens->reserve(file.size() / 4); //Saves copying while the vector grows
+	vector<pair<size_t, size_t>> directives;
+	bool lineStart = true;
+	while (!lexer.empty()) {
+		size_t offset = buffer.offset(); //Where the next lexeme starts
+		tokens->push_back(lexer.get());
+		const PPToken& token = tokens->back();
+		if (token.getSymbol() == SYM_NEWLINE) {
+			lineStart = true;
+		} else if (token.getKey() != WHITESPACE) {
+			if (lineStart && token.getSymbol() == SYM_HASH) {
+				directives.push_back(make_pair(tokens->size() - 1, offset));
+			}
+			lineStart = false;
+		}
+		buffer.trim(1);
+		buffer.reset();
+	}
+	return new LexedFile(tokens, directives);
+}
+
+//Index after the end of a comment starting at at, counting its new-lines
+static size_t endOfComment(const char* data, size_t length, size_t at, \
+		unsigned int& line) {
+	while (at < length) {
+		if (data[at] == '\n') {
+			++line;
+		} else if (data[at] == '*' && at + 1 < length && data[at + 1] == '/') {
+			return at + 2;
+		}
+		++at;
+	}
+	return at;
+}
+
+//Index after the new-line ending the line at at, or the length. Comments,
+//literals and line splices are stepped over, counting the new-lines passed.
+static size_t endOfLine(const char* data, size_t length, size_t at, \
+		unsigned int& line) {
+	bool lineComment = false; //Nothing but splices end it before the new-line
+	while (at < length) {
+		char c = data[at++];
+		if (c == '\n') {
+			++line;
+			return at;
+		} else if (c == '\\' && at < length && data[at] == '\n') {
+			++line;
+			++at;
+		} else if (lineComment) {
+			continue;
+		} else if (c == '/' && at < length && data[at] == '*') {
+			at = endOfComment(data, length, at + 1, line);
+		} else if (c == '/' && at < length && data[at] == '/') {
+			lineComment = true;
+			++at;
+		} else if (c == '"' || c == '\'') {
+			while (at < length && data[at] != c && data[at] != '\n') {
+				if (data[at] == '\\' && at + 1 < length) {
+					line += data[at + 1] == '\n';
+					++at;
+				}
+				++at;
+			}
+			at += at < length && data[at] == c;
+		}
+	}
+	return at;
+}
+
+//! Lexes the directives of a file and leaves out all other lines
+/*! Lines are told apart by looking at their first characters, the rest of
+ * an ordinary line is only looked at for comments and literals which hide
+ * or continue it. Each directive line is lexed on its own and its tokens are
+ * given the lines they have in the file. The result is what lex() gives for
+ * a file where every line which is not a directive is empty.
+ */
+LexedFile* TokenCache :: lexDirectives(const string& filename) {
+	MappedFileSource file(filename);
+	const char* data = file.getData();
+	size_t length = file.size();
+	vector<PPToken>* tokens = new vector<PPToken>();
+	vector<pair<size_t, size_t>> directives;
+	unsigned int line = 1;
+	size_t at = 0;
+	while (at < length) {
+		//Only white-space and comments may come before the '#'
+		unsigned int first = line;
+		size_t hash = at;
+		while (hash < length) {
+			char c = data[hash];
+			if (c == ' ' || c == '\t' || c == '\f' || c == '\v' || c == '\r') {
+				++hash;
+			} else if (c == '/' && hash + 1 < length && data[hash + 1] == '*') {
+				hash = endOfComment(data, length, hash + 2, line);
+			} else if (c == '/' && hash + 1 < length && data[hash + 1] == '/') {
+				break; //The rest of the line is a comment, endOfLine() skips it
+			} else if (c == '\\' && hash + 1 < length && data[hash + 1] == '\n') {
+				++line;
+				hash += 2;
+			} else {
+				break;
+			}
+		}
+		size_t end = endOfLine(data, length, hash, line);
+		if (hash < length && data[hash] == '#') {
+			MappedFileSource directive(data + at, end - at);
+			LineSplicer splicer(&directive);
+			BufferedSource<char> buffer(&splicer);
+			Lexer lexer(&buffer, &splicer.getSplices());
+			size_t index = tokens->size();
+			while (!lexer.empty()) {
+				PPToken token = lexer.get();
+				tokens->push_back(PPToken(Position(token.getLine() + first - 1, \
+								token.getColumn()), token.getSymbol(), token.getKey()));
+				if (index == tokens->size() - 1 && token.getKey() == WHITESPACE) {
+					++index; //Not the '#' yet
+				}
+				buffer.trim(1);
+				buffer.reset();
+			}
+			directives.push_back(make_pair(index, hash));
+		}
+		at = end;
+	}
+	return new LexedFile(tokens, directives);
+}
+
+LexedFile :: LexedFile(vector<PPToken>* tokens, \
+		const vector<pair<size_t, size_t>>& directives) : tokens(tokens), \
+	guard(""), guardedBegin(0), guardedEnd(0) {
+	for (const pair<size_t, size_t>& directive : directives) {
+		this->indexDirective(directive.first, directive.second, 0);
+	}
+	this->findGuard();
+}
+
+void LexedFile :: indexDirective(size_t at, size_t offset, size_t base) {
+	static const map<unsigned int, Conditional::Kind> kinds = {
+		{SYM_IF, Conditional::IF}, {SYM_IFDEF, Conditional::IFDEF}, \
+		{SYM_IFNDEF, Conditional::IFNDEF}, {SYM_ELIF, Conditional::ELIF}, \
+		{SYM_ELSE, Conditional::ELSE}, {SYM_ENDIF, Conditional::ENDIF}};
+	size_t name = this->skipWhiteSpace(at + 1, false);
+	if (name >= this->tokens->size()) {
+		return;
+	}
+	unsigned int kind = (*this->tokens)[name].getSymbol();
+	auto search = kinds.find(kind);
+	if (search != kinds.end()) {
+		this->conditionals.push_back(Conditional(search->second, \
+					base + at, base + name + 1, offset));
+	} else if (kind == SYM_INCLUDE) {
+		this->headerName(this->skipWhiteSpace(name + 1, false));
+	}
+}
+
+TokenStream :: TokenStream(const string& filename) : \
+	LexedFile(new vector<PPToken>()), source(filename), splicer(&source), \
+	buffer(&splicer), lexer(&buffer, &splicer.getSplices()), base(0) {}
+
+//! Lexes the tokens of the next line, up to and including its new-line
+/*! The window is only trimmed when most of it is no longer needed, so that
+ * the tokens kept are not moved for every line.
+ */
+bool TokenStream :: more(size_t keep) {
+	if (this->lexer.empty()) {
+		return false;
+	}
+	size_t dead = keep > this->base ? keep - this->base : 0;
+	if (dead >= minTrim && 2*dead > this->tokens->size()) {
+		this->tokens->erase(this->tokens->begin(), \
+				this->tokens->begin() + dead);
+		this->base = keep;
+	}
+	size_t directive = 0;
+	size_t directiveOffset = 0;
+	bool lineStart = true;
+	while (!this->lexer.empty()) {
+		size_t offset = this->buffer.offset(); //Where the next lexeme starts
+		this->tokens->push_back(this->lexer.get());
+		this->buffer.trim(1);
+		this->buffer.reset();
+		const PPToken& token = this->tokens->back();
+		if (token.getSymbol() == SYM_NEWLINE) {
+			break;
+		} else if (token.getKey() != WHITESPACE) {
+			if (lineStart && token.getSymbol() == SYM_HASH) {
+				directive = this->tokens->size();
+				directiveOffset = offset;
+			}
+			lineStart = false;
+		}
+	}
+	if (directive > 0) {
+		this->indexDirective(directive - 1, directiveOffset, this->base);
+	}
+	return true;
+}
+
+//Keeps the header name starting at at, if there is one, like it is put
+//together by TokenReplay::matchHeaderName()
+void LexedFile :: headerName(size_t at) {
+	if (at >= this->tokens->size()) {
+		return;
+	}
+	string name = (*this->tokens)[at].getName();
+	if (name != "<" && name != "\"") {
+		return;
+	}
+	string end = name == "<" ? ">" : "\"";
+	for (++at; at < this->tokens->size(); ++at) {
+		const string& part = (*this->tokens)[at].getName();
+		if (part == "\n") {
+			return;
+		}
+		name += part;
+		if (part == end) {
+			this->includes.push_back(name);
+			return;
+		}
+	}
+}
+
+//Index of the first token at or after at which is not white-space
+size_t LexedFile :: skipWhiteSpace(size_t at, bool newLines) const {
+	while (at < this->tokens->size()) {
+		PPToken& token = (*this->tokens)[at];
+		if (token.getKey() != WHITESPACE || \
+				(!newLines && token.getSymbol() == SYM_NEWLINE)) {
+			break;
+		}
+		++at;
+	}
+	return at;
+}
+
+//If a directive with the name, a KnownSymbol, starts at at, the index of the
+//token after the name, otherwise 0
+size_t LexedFile :: directive(size_t at, unsigned int name) const {
+	if (at >= this->tokens->size() || \
+			(*this->tokens)[at].getSymbol() != SYM_HASH) {
+		return 0;
+	}
+	at = this->skipWhiteSpace(at + 1, false);
+	if (at >= this->tokens->size() || \
+			(*this->tokens)[at].getSymbol() != name) {
+		return 0;
+	}
+	return at + 1;
+}
+
+void LexedFile :: findGuard() {
+	size_t size = this->tokens->size();
+	//#ifndef X
+	size_t at = this->directive(this->skipWhiteSpace(0, true), SYM_IFNDEF);
+	if (at == 0) {
+		return;
+	}
+	at = this->skipWhiteSpace(at, false);
+	if (at >= size || (*this->tokens)[at].getKey() != IDENTIFIER) {
+		return;
+	}
+	string macro = (*this->tokens)[at].getName();
+	at = this->skipWhiteSpace(at + 1, false);
+	if (at >= size || (*this->tokens)[at].getSymbol() != SYM_NEWLINE) {
+		return;
+	}
+	size_t begin = at + 1;
+	//#define X
+	at = this->directive(this->skipWhiteSpace(begin, true), SYM_DEFINE);
+	if (at == 0) {
+		return;
+	}
+	at = this->skipWhiteSpace(at, false);
+	if (at >= size || (*this->tokens)[at].getName() != macro) {
+		return;
+	}
+	//The #endif matching the #ifndef has to be the last thing in the file
+	unsigned int depth = 1;
+	bool lineStart = false;
+	for (; at < size; ++at) {
+		PPToken& token = (*this->tokens)[at];
+		if (token.getSymbol() == SYM_NEWLINE) {
+			lineStart = true;
+			continue;
+		}
+		if (token.getKey() == WHITESPACE) {
+			continue;
+		}
+		if (lineStart && token.getSymbol() == SYM_HASH) {
+			size_t name = this->skipWhiteSpace(at + 1, false);
+			unsigned int kind = name < size ? \
+				(*this->tokens)[name].getSymbol() : SYM_EMPTY;
+			if (kind == SYM_IF || kind == SYM_IFDEF || kind == SYM_IFNDEF) {
+				++depth;
+			} else if ((kind == SYM_ELSE || kind == SYM_ELIF) && depth == 1) {
+				return; //The guard does not cover the whole file
+			} else if (kind == SYM_ENDIF && --depth == 0) {
+				//Only white-space may follow the #endif line
+				size_t end = name + 1;
+				while (end < size && \
+						(*this->tokens)[end].getSymbol() != SYM_NEWLINE) {
+					++end;
+				}
+				if (this->skipWhiteSpace(end, true) < size) {
+					return;
+				}
+				this->guard = macro;
+				this->guardedBegin = begin;
+				this->guardedEnd = at;
+				return;
+			}
+		}
+		lineStart = false;
+	}
+}
+
+void PreprocessedWriter :: put(PPToken token) {
+	if (!this->preprocessor.getFileChanges().empty()) {
+		this->changeFiles();
+	}
+	const string& name = token.getName();
+	if (name.length() == 0) {
+		return; //E.g. for an #include which was skipped
+	}
+	unsigned int tokenLine = token.getLine();
+	if (this->lineStart && tokenLine > 0 && tokenLine != this->line) {
+		if (tokenLine > this->line && tokenLine - this->line <= maxGap) {
+			while (this->line < tokenLine) {
+				this->write("\n", 1);
+				++this->line;
+			}
+		} else {
+			this->line = tokenLine;
+			this->marker(this->line, "");
+		}
+	}
+	if (token.getSymbol() == SYM_NEWLINE) {
+		this->write("\n", 1);
+		this->lineStart = true;
+		this->line = (tokenLine > 0 ? tokenLine : this->line) + 1;
+	} else {
+		this->write(name);
+		this->lineStart = false;
+	}
+}
+
+//! Writes a marker for each file entered or left since the last token
+/*! The stack of files is pushed and popped as the Preprocessor reports,
+ * so a header included twice in a row is left and entered again.
+ */
+void PreprocessedWriter :: changeFiles() {
+	vector<Preprocessor::FileChange>& changes = \
+		this->preprocessor.getFileChanges();
+	if (!this->lineStart) {
+		this->write("\n", 1);
+		this->lineStart = true;
+	}
+	for (const Preprocessor::FileChange& change : changes) {
+		if (change.entered) {
+			this->files.push_back(change.filename);
+			this->systems.push_back(change.system);
+		} else if (this->files.size() > 1) {
+			this->files.pop_back();
+			this->systems.pop_back();
+		}
+		this->line = change.line;
+		this->marker(this->line, change.entered ? " 1" : " 2");
+	}
+	changes.clear();
+}
+
+void PreprocessedWriter :: marker(unsigned int line, const char* flag) {
+	this->write("# ", 2);
+	this->write(to_string(line));
+	this->write(" \"", 2);
+	this->write(this->files.back());
+	this->write("\"", 1);
+	this->write(flag, strlen(flag));
+	if (this->systems.back()) {
+		this->write(" 3", 2);
+	}
+	this->write("\n", 1);
+}
+
+void PreprocessedWriter :: write(const char* chars, size_t length) {
+	while (length > 0) {
+		size_t count = min(length, this->buffer.size() - this->used);
+		memcpy(&this->buffer[this->used], chars, count);
+		this->used += count;
+		chars += count;
+		length -= count;
+		if (this->used == this->buffer.size()) {
+			this->flush();
+		}
 	}
-	bufLexSource->trim(1);
-	bufLexSource->reset();
-	return lexer->get();
 }
 
+void PreprocessedWriter :: finish() {
+	if (!this->preprocessor.getFileChanges().empty()) {
+		this->changeFiles();
+	}
+	if (!this->lineStart) {
+		this->write("\n", 1);
+		this->lineStart = true;
+	}
+	this->flush();
+}
+
+void PreprocessedWriter :: flush() {
+	size_t done = 0;
+	while (done < this->used) {
+		ssize_t written = ::write(this->fd, &this->buffer[done], \
+				this->used - done);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			string err = "Could not write preprocessed output";
+			throw IOException(err);
+		}
+		done += written;
+	}
+	this->used = 0;
+}
@@ -1,11 +1,62 @@
 #include "source.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-//Empty because implementations of unspecialized templates can not be defined in 
-//a file that is invisible to some translation unit that uses the template.
-//I.e., since source.h only has template classes, all implementation details must
-//be kept in source.h. 
+//Implementations of unspecialized templates can not be defined in a file that
+//is invisible to some translation unit that uses the template.
+//I.e., all implementation details of the template classes in source.h must be
+//kept in source.h. Only the non-template sources are implemented here.
 //
 //More info at:
 //http://stackoverflow.com/a/12574417
 //http://stackoverflow.com/q/495021
 
+MappedFileSource :: MappedFileSource(string filename) : data(NULL), length(0),\
+														pos(0), owned(true) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw IOException("Could not open filestream for file " + filename);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw IOException("Could not stat file " + filename);
+	}
+	this->length = info.st_size;
+	if (this->length > 0) {
+		void* mapped = mmap(NULL, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(fd);
+			throw IOException("Could not map file " + filename);
+		}
+		madvise(mapped, this->length, MADV_SEQUENTIAL);
+		this->data = (const char*) mapped;
+	}
+	//The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFileSource :: ~MappedFileSource() {
+	if (this->owned && this->data != NULL) {
+		munmap((void*) this->data, this->length);
+	}
+}
+
+size_t MappedFileSource :: getBatch(char* out, size_t max) {
+	size_t count = 0;
+	if (this->pos < this->length) {
+		count = this->length - this->pos;
+		if (count > max) {
+			count = max;
+		}
+		memcpy(out, this->data + this->pos, count);
+		this->pos += count;
+	}
+	if (count < max && !this->empty()) {
+		out[count++] = this->get(); //Reads past the end, as get() would
+	}
+	return count;
+}
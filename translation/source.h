@@ -1,5 +1,6 @@
 #include <sstream>
-#include <deque>
+#include <algorithm>
+#include <vector>
 #include <list>
 #include <map>
 #include "tokenizer.h"
@@ -26,6 +27,16 @@ class Source
 	public:
 		virtual T get() = 0; //Gets the next item from the source
 		virtual bool empty() = 0; //True if source has no more items
+		//Gets up to max items into out and returns how many were gotten. Stops
+		//early only when the source is empty, so the result is the same as 
+		//calling get() until empty() is true. Override with something faster.
+		virtual size_t getBatch(T* out, size_t max) {
+			size_t count = 0;
+			while (count < max && !this->empty()) {
+				out[count++] = this->get();
+			}
+			return count;
+		}
 		virtual ~Source() {}
 		Position getPosition() {return this->position;}
 		void newLine() {position.setLine(position.getLine() + 1);
@@ -44,6 +55,19 @@ class Source
 		
 };
 
+//! Implements getBatch() for a Source of type S without virtual calls
+/*! Meant for sources whose get() does too much per item to be batched in a
+ * smarter way, but which can still save the virtual calls of the default.
+ */
+template<class S, class T>
+size_t getEach(S* source, T* out, size_t max) {
+	size_t count = 0;
+	while (count < max && !source->S::empty()) {
+		out[count++] = source->S::get();
+	}
+	return count;
+}
+
 template<class T> 
 class StreamSource : public virtual Source<T> {
 	public:
@@ -57,40 +81,190 @@ class StreamSource : public virtual Source<T> {
 		basic_istream<T>* inputstream;
 };
 
+//! A Source of items which have already been collected from another source
+/*! empty() is true once the last item has been gotten, after that get()
+ * asks the source the items were collected from, so that reading past the
+ * end works the same as it did there.
+ */
+template<class T>
+class VectorSource : public Source<T> {
+	public:
+		VectorSource(const vector<T>* items, Source<T>* drained) : \
+			items(items), drained(drained), next(0) {}
+		T get() {
+			if (this->next < this->items->size()) {
+				return (*this->items)[this->next++];
+			}
+			return this->drained->get();
+		}
+		bool empty() {return this->next >= this->items->size();}
+		size_t getBatch(T* out, size_t max) {
+			size_t count = min(max, this->items->size() - this->next);
+			const T* first = this->items->data() + this->next;
+			std::copy(first, first + count, out);
+			this->next += count;
+			return count;
+		}
+	private:
+		const vector<T>* items;
+		Source<T>* drained;
+		size_t next; //Index of the item to get next
+};
+
+//! A Source of the bytes of a file, read through a read-only memory mapping
+/*! The whole file is mapped once and never copied. Like StreamSource, empty()
+ * only becomes true after a get() has been attempted past the end of the file.
+ */
+class MappedFileSource : public Source<char> {
+	public:
+		MappedFileSource(string filename);
+		//Part of a file which is already mapped, it is not unmapped by this
+		MappedFileSource(const char* data, size_t length) : data(data), \
+			length(length), pos(0), owned(false) {}
+		char get() {
+			if (this->pos < this->length) {
+				return this->data[this->pos++];
+			}
+			this->pos = this->length + 1;
+			return '\0';
+		}
+		bool empty() {return this->pos > this->length;}
+		size_t getBatch(char* out, size_t max);
+		const char* getData() {return this->data;}
+		size_t size() {return this->length;}
+		virtual ~MappedFileSource();
+	private:
+		const char* data;
+		size_t length;
+		size_t pos;
+		bool owned; //True if the mapping was made by this source
+};
+
+template<class T>
+class BufferedSource;
+
+//! A position in a BufferedSource which can be returned to
+/*! Obtained from BufferedSource::mark(), see there. The mark is held until
+ * commit() or until the checkpoint goes out of scope, whichever is first, so
+ * a parse which throws while it holds one does not leak it. The source is
+ * left where it was when the mark is released that way.
+ */
+template<class T>
+class Checkpoint {
+	public:
+		Checkpoint(BufferedSource<T>* source, size_t position, \
+				unsigned int depth) : source(source), position(position), \
+									  depth(depth), held(true) {}
+		Checkpoint(Checkpoint&& other) : source(other.source), \
+			position(other.position), depth(other.depth), held(other.held) {
+			other.held = false;
+		}
+		Checkpoint(const Checkpoint&) = delete;
+		Checkpoint& operator=(const Checkpoint&) = delete;
+		~Checkpoint() {this->commit();}
+		size_t getPosition() const {return position;}
+		void rewind() {source->seek(position);}
+		//Releases the mark together with all marks taken after it
+		void commit() {
+			if (held) {
+				source->release(depth);
+				held = false;
+			}
+		}
+	private:
+		BufferedSource<T>* source;
+		size_t position; //Index of the next item to get, counted from the start
+		unsigned int depth; //Number of marks held when this one was taken
+		bool held;
+};
+
+//! A Source which keeps fetched items so that they can be read again
+/*! The items are kept in a ring buffer which doubles in size when full. All
+ * positions are counted from the start of the source and are only masked when
+ * indexing into the ring, so dropping items from the front of the buffer is a
+ * matter of moving 'head' forward.
+ *
+ * Backtracking is done with checkpoints: mark() returns the current position,
+ * Checkpoint::rewind() goes back to it and Checkpoint::commit() releases it
+ * together with all marks taken after it. When no marks are held, that also
+ * drops the items which have already been read. seek() moves to any position
+ * read since the oldest mark held.
+ *
+ * Items are pulled from the underlying source with getBatch(), batchSize at a
+ * time. The buffer only hands out items up to 'fetched', the position the 
+ * source would have reached if items had been pulled one at a time, and 
+ * empty() is answered for that position. Reading ahead is therefore not 
+ * visible to the user of the buffer.
+ */
 template<class T>
 class BufferedSource : public Source<T> {
 	public:
-		BufferedSource(string filename) : source(new StreamSource<char>(filename)), \
-				que(*new deque<T>()) {this->used = 0;}
-		BufferedSource(Source<T>* s) : source(s), que(*new deque<T>()) {
-				this->used = 0;
+		BufferedSource(string filename) : \
+			BufferedSource(new StreamSource<char>(filename)) {}
+		BufferedSource(Source<T>* s) : source(s), ring(2*batchSize), \
+									   mask(2*batchSize - 1), head(0), tail(0), \
+									   fetched(0), cursor(0), marks(0), \
+									   emptyAt(noPosition) {}
+		T get() {
+			if (this->cursor == this->fetched) {
+				this->fetch();
 			}
-		T get();
-		T peek();
+			return this->ring[this->cursor++ & this->mask];
+		}
+		size_t getBatch(T* out, size_t max) {return getEach(this, out, max);}
+		T peek() {return this->peek(0);}
 		T peek(unsigned int ahead);
-		void reset() {used = 0;} //Move stream back to beginning of buffer
+		//True if the source had an item that many after the next one to get,
+		//unlike peek() which goes on past its end
+		bool has(unsigned int ahead) {
+			while (this->fetched <= this->cursor + ahead && !this->empty()) {
+				this->fetch();
+			}
+			return this->cursor + ahead < this->emptyAt;
+		}
+		void reset() {cursor = head;} //Move stream back to beginning of buffer
 		void clear() {
 			this->trim(0);
 			this->reset();
 		}
-		void clearUsed();
+		void clearUsed() {head = cursor;} //Drop all items that have been read
 		void trim(unsigned int leave) {
-			while (que.size() > leave) {
-				que.pop_front();
+			if (fetched - head > leave) {
+				head = fetched - leave;
 			}
-			used = 0;
+			cursor = head;
 		} //Trim down buffer to the size of leave (if needed) and reset to beginning
 		//of trimmed buffer
-		/*bool empty() {return source->empty() && (this->used >= \
-				this->que.size());}*/
-		bool empty() {return source->empty();}
+		size_t offset() {return cursor;} //Position of the item to get next
+		void copy(size_t start, size_t length, T* out);
+		Checkpoint<T> mark() {return Checkpoint<T>(this, cursor, marks++);}
+		void seek(size_t position) {cursor = position;}
+		bool empty() {return this->fetched >= this->emptyAt;}
 		virtual ~BufferedSource() {}
-		unsigned int bufferSize() {return used;}
-		void setUsed(unsigned int in) {this->used = in;}
+		static const size_t batchSize = 256;
 	private:
-		unsigned int used;
+		friend class Checkpoint<T>;
+		//Releases the marks taken when depth were held, and those after them
+		void release(unsigned int depth) {
+			if (depth < marks) {
+				marks = depth;
+			}
+			if (marks == 0) {
+				head = cursor;
+			}
+		}
+		void fetch(); //Make one more item from the source available
+		void refill(); //Pull the next batch of items from the source
+		static const size_t noPosition = (size_t) -1;
 		Source<T>* source;
-		deque<T>& que;
+		vector<T> ring;
+		size_t mask; //ring.size() - 1, the size is always a power of two
+		size_t head; //Position of the first item in the buffer
+		size_t tail; //Position after the last item pulled from the source
+		size_t fetched; //Position after the last item made available
+		size_t cursor; //Position of the item to get next
+		unsigned int marks; //Number of marks held
+		size_t emptyAt; //Position at which the source became empty, if known
 };
 
 
@@ -109,46 +283,66 @@ class Phase : public Source<To>, public Mapping<From, To> {
 };
 
 template <class T>
-T BufferedSource<T> :: get() {
-	//If we've already used all items we've fetched from the unbuffered source, 
-	//fetch one more, add it to the buffer and return it.
-	if (this->used >= this->que.size()) {
-		T gotten = this->source->get();
-		que.push_back(gotten);
-		used++; //Since we're using the item that we just got
-		return gotten;
-		//Otherwise, return the next element in the buffer and move one step
-	} else {
-		return que.at(used++);
+void BufferedSource<T> :: fetch() {
+	if (this->fetched == this->tail) {
+		this->refill();
 	}
+	++this->fetched;
 }
 
 template <class T>
-T BufferedSource<T> :: peek() {
-	unsigned int temp_used = this->used;
-	T val = this->get();
-	this->used = temp_used; //Do not 'use' the element
-	return val;
+void BufferedSource<T> :: refill() {
+	while (this->ring.size() - (this->tail - this->head) < batchSize) {
+		//Too full, double the size and move the items to their new slots
+		vector<T> larger(2*this->ring.size());
+		size_t largerMask = larger.size() - 1;
+		for (size_t i = this->head; i != this->tail; ++i) {
+			larger[i & largerMask] = std::move(this->ring[i & this->mask]);
+		}
+		this->ring.swap(larger);
+		this->mask = largerMask;
+	}
+	//Pull into the free slots up to the end of the ring, the rest on next refill
+	size_t slot = this->tail & this->mask;
+	size_t room = this->ring.size() - slot;
+	size_t free = this->ring.size() - (this->tail - this->head);
+	if (room > free) {
+		room = free;
+	}
+	size_t count = this->source->getBatch(&this->ring[slot], \
+			room < batchSize ? room : batchSize);
+	if (count == 0) {
+		//Already empty, but keep asking the source as get() would have
+		this->ring[slot] = this->source->get();
+		count = 1;
+	}
+	this->tail += count;
+	if (this->emptyAt == noPosition && this->source->empty()) {
+		this->emptyAt = this->tail;
+	}
 }
 
-//Look ahead as many elements as given in the argument.
-//@param ahead How many elements to look ahead. 0 (zero) is the same as peek().
+//Copy items that are still in the buffer, e.g. to build a lexeme from them.
+//@param start Position of the first item, as given by offset()
+//@param length Number of items to copy
+//@param out Where the items are copied to
 template <class T>
-T BufferedSource<T> :: peek(unsigned int ahead) {
-	unsigned int old_used = this->used;
-	T token = this->get();
-	for (int i = ahead; i > 0; --i) {
-		token = this->get();
+void BufferedSource<T> :: copy(size_t start, size_t length, T* out) {
+	size_t slot = start & this->mask;
+	size_t first = this->ring.size() - slot; //Items before the ring wraps around
+	if (first > length) {
+		first = length;
 	}
-	this->used = old_used; //Restore the number of used items
-	return token;
+	std::copy(&this->ring[slot], &this->ring[slot] + first, out);
+	std::copy(&this->ring[0], &this->ring[0] + (length - first), out + first);
 }
 
+//Look ahead as many elements as given in the argument.
+//@param ahead How many elements to look ahead. 0 (zero) is the same as peek().
 template <class T>
-void BufferedSource<T> :: clearUsed() {
-	for (unsigned int i = 0; i < this->used; ++i) {
-		this->que.pop_front();
+T BufferedSource<T> :: peek(unsigned int ahead) {
+	while (this->fetched - this->cursor <= ahead) {
+		this->fetch();
 	}
-	this->used = 0;
+	return this->ring[(this->cursor + ahead) & this->mask];
 }
-
@@ -82,7 +82,6 @@ string ParameterDeclaration :: genLLVM(Scope* s, Consumer<string>* o) {
 			//So, do not enter anything if typeName is void
 			o->put(typeName);
 		}
-		delete declSpecType;
 	}
 	if (decl != NULL) {o->put(" %__arg_" + to_string(s->getTemp()));}
 	return "";
@@ -107,6 +106,18 @@ Declarator :: ~Declarator() {
 	//if (pointer != NULL) {delete pointer;}
 }
 
+Identifier* Declarator :: getIdentifier() {
+	if (IdentifierDirectDeclarator* idDirDecl = \
+			dynamic_cast<IdentifierDirectDeclarator*>(this->dirDecl)) {
+		return idDirDecl->getIdentifier();
+	} else if (DeclaratorDirectDeclarator* declDirDecl = \
+			dynamic_cast<DeclaratorDirectDeclarator*>(this->dirDecl)) {
+		Declarator* decl = declDirDecl->getDeclarator();
+		return decl != NULL ? decl->getIdentifier() : NULL;
+	}
+	return NULL;
+}
+
 string Declarator :: getName() {
 	string ret = "";
 	if (pointer != NULL) {
@@ -136,7 +147,7 @@ bool BlockItem :: typeCheck(Scope* s) {
 Type* BlockItem :: getType(Scope* s) {
 	if (decl != NULL) {return decl->getType(s);}
 	if (state != NULL) {return state->getType(s);}
-	return new NoType();
+	return TypeContext::getNoType();
 }
 
 string BlockItem :: genLLVM(Scope* s, Consumer<string>* o) {
@@ -157,61 +168,55 @@ Pointer :: ~Pointer() {
 }
 
 TranslationUnit* Parser :: parseTranslationUnit() {
-	TranslationUnit* ret = NULL;
-	ExternalDeclaration* decl = NULL;
-	decl = parseExternalDeclaration();
+	ExternalDeclaration* decl = parseExternalDeclaration();
 	if (decl == NULL) {
 		return NULL;
-	} else {
-		TranslationUnit* next = parseTranslationUnit();
-		ret = new TranslationUnit(decl, next);
+	}
+	TranslationUnit* ret = new TranslationUnit(decl);
+	while ((decl = parseExternalDeclaration()) != NULL) {
+		ret->add(decl);
 	}
 	return ret;
 }
 
 ExternalDeclaration* Parser :: parseExternalDeclaration() {
-	/* First, attempt to parse as a declaration, using the trailing ';' to 
-	 * determine if there was a match. If no match, reset the buffered source 
-	 * to its previous state and parse as a function declaration
+	/* The specifiers and the first declarator are the same for a declaration
+	 * and a function definition, so they are parsed once and the token after
+	 * them tells which it is. Only a declaration has ';', ',' or '=' there.
 	 */
-	ExternalDeclaration* ret = NULL;
-	unsigned int bufferUsed = source->bufferSize();
 	DeclarationSpecifierList* declSpecList = parseDeclarationSpecifierList();
-	InitDeclaratorList* initDeclList = parseInitDeclaratorList();
+	Declarator* decl = parseDeclarator();
+	if (declSpecList == NULL && decl == NULL) {
+		return NULL; //E.g. at the end of the input
+	}
 	Token token = source->peek();
-	if (token.getName() == ";") {
-		source->get();
-		Declaration* decl = new Declaration(declSpecList, initDeclList);
-		ret = new ExternalDeclaration(decl);
-	} else {
-		//Not a declaration, try a function definition instead
-		source->setUsed(bufferUsed);
-		FunctionDefinition* funcDef = parseFunctionDefinition();
-		if (funcDef != NULL) {
-			ret = new ExternalDeclaration(funcDef);
-		}
+	if (declSpecList != NULL && decl != NULL && \
+			token.getSymbol() != SYM_SEMICOLON && \
+			token.getSymbol() != SYM_COMMA && token.getSymbol() != SYM_ASSIGN) {
+		return new ExternalDeclaration(parseFunctionDefinition(declSpecList, \
+					decl));
+	}
+	InitDeclaratorList* initDeclList = parseInitDeclaratorList(decl);
+	if (source->peek().getSymbol() != SYM_SEMICOLON) {
+		if (declSpecList != NULL) {delete declSpecList;}
+		if (initDeclList != NULL) {delete initDeclList;}
+		return NULL;
 	}
-	return ret;
+	source->get();
+	this->addTypedefNames(declSpecList, initDeclList);
+	return new ExternalDeclaration(new Declaration(declSpecList, initDeclList));
 }
 
-FunctionDefinition* Parser :: parseFunctionDefinition() {
-	FunctionDefinition* ret = NULL;
-	DeclarationSpecifierList* declSpecList = parseDeclarationSpecifierList();
-	if (declSpecList == NULL) {
-		return NULL;
-	}
-	Declarator* decl = parseDeclarator();
-	if (decl == NULL) {
-		return NULL;
-	}
+//! The rest of a function definition, after its declarator
+FunctionDefinition* Parser :: parseFunctionDefinition( \
+		DeclarationSpecifierList* declSpecList, Declarator* decl) {
 	DeclarationList* declList = NULL;
 	Token token = source->peek();
-	if (token.getName() != "{") {
+	if (token.getSymbol() != SYM_LBRACE) {
 		declList = parseDeclarationList();
 	}
 	CompoundStatement* state = parseCompoundStatement();
-	ret = new FunctionDefinition(declSpecList, decl, declList, state);
-	return ret;
+	return new FunctionDefinition(declSpecList, decl, declList, state);
 }
 
 Statement* Parser :: parseStatement() {
@@ -226,7 +231,7 @@ Statement* Parser :: parseStatement() {
 			currentName == "while") {
 		return parseIterationStatement();
 	} else if (currentName == "case" || currentName == "default" || \
-			source->peek(1).getName() == ":") {
+			source->peek(1).getSymbol() == SYM_COLON) {
 		return parseLabeledStatement();
 	} else if (currentName == "\{") {
 		return parseCompoundStatement();
@@ -243,7 +248,7 @@ CompoundStatement* Parser :: parseCompoundStatement() {
 	CompoundStatement* ret = NULL;
 	BlockItemList* itemList = NULL;
 	string err;
-	if (current.getName() == "\{") {
+	if (current.getSymbol() == SYM_LBRACE) {
 		try {
 			itemList = parseBlockItemList();
 		} catch (BlockItemListException) {
@@ -251,7 +256,7 @@ CompoundStatement* Parser :: parseCompoundStatement() {
 			return new CompoundStatement();
 		}
 		current = source->get();
-		if (current.getName() != "}") {
+		if (current.getSymbol() != SYM_RBRACE) {
 			err = "Expected '}' after compound statement";
 			throw new SyntaxException(err);
 		}
@@ -264,60 +269,62 @@ CompoundStatement* Parser :: parseCompoundStatement() {
 }
 
 BlockItemList* Parser :: parseBlockItemList() {
-	BlockItem* first = parseBlockItem();
-	BlockItemList* next = NULL;
-	if (source->peek().getName() == "}") {
-		return new BlockItemList(first);
-	}
-	try {
-		next = parseBlockItemList();
-	} catch (BlockItemListException) {
-		//No more lists, which is okay
+	BlockItemList* ret = new BlockItemList(parseBlockItem());
+	while (source->peek().getSymbol() != SYM_RBRACE) {
+		try {
+			ret->add(parseBlockItem());
+		} catch (BlockItemListException) {
+			//No more items, which is okay
+			break;
+		}
 	}
-	return new BlockItemList(first, next);
+	return ret;
 }
 
+//! Parses a declaration or a statement, deciding which by the first token
+/*! Only a declaration starts with a declaration specifier, which may be a
+ * typedef name declared before. Typedef names are not scoped, so a variable
+ * which hides one still starts a declaration.
+ */
 BlockItem* Parser :: parseBlockItem() {
-	BlockItem* ret = NULL;
-	unsigned int bufferUsed = source->bufferSize();
-	Declaration* decl = NULL;
-	try {
-		decl = parseDeclaration();
-	} catch (ExpressionException) {
-		decl = NULL;
-	} catch (DirectDeclaratorException) {
-		decl = NULL;
+	if (this->isDeclarationSpecifier(source->peek().getSymbol())) {
+		Declaration* decl = parseDeclaration();
+		return decl != NULL ? new BlockItem(decl) : NULL;
 	}
-	Statement* state = NULL;
-	unsigned int declUsed = source->bufferSize();
-	unsigned int stateUsed = 0;
-	source->setUsed(bufferUsed);
-	try {
-		state = parseStatement();
-		stateUsed = source->bufferSize();
-	} catch (ExpressionException) {
-		state = NULL;
-	}
-	if (state != NULL && decl != NULL) {
-		//Both matches, compare length
-		if (stateUsed >= declUsed) {
-			source->setUsed(stateUsed);
-			ret = new BlockItem(state);
-		} else {
-			source->setUsed(declUsed);
-			ret = new BlockItem(decl);
+	return new BlockItem(parseStatement());
+}
+
+bool Parser :: isDeclarationSpecifier(unsigned int symbol) const {
+	return this->mStorageClassSpecifier.count(symbol) > 0 || \
+		this->mTypeSpecifier.count(symbol) > 0 || \
+		this->mTypeQualifier.count(symbol) > 0 || \
+		this->mFunctionSpecifier.count(symbol) > 0 || \
+		this->mAlignmentSpecifier.count(symbol) > 0 || \
+		this->mTypedefName.count(symbol) > 0;
+}
+
+//! Makes the identifiers declared with a typedef storage class typedef names
+void Parser :: addTypedefNames(DeclarationSpecifierList* declSpecList, \
+		InitDeclaratorList* initDeclList) {
+	if (declSpecList == NULL || initDeclList == NULL) {
+		return;
+	}
+	bool isTypedef = false;
+	for (DeclarationSpecifier* spec : declSpecList->getItems()) {
+		isTypedef = isTypedef || (spec != NULL && \
+				dynamic_cast<StorageClassSpecifier*>(spec) != NULL && \
+				spec->getName() == "typedef");
+	}
+	if (!isTypedef) {
+		return;
+	}
+	for (InitDeclarator* initDecl : initDeclList->getItems()) {
+		Declarator* decl = initDecl != NULL ? initDecl->getDeclarator() : NULL;
+		Identifier* id = decl != NULL ? decl->getIdentifier() : NULL;
+		if (id != NULL) {
+			this->mTypedefName.insert(Interner::intern(id->getName()));
 		}
-	} else if (decl != NULL) {
-		source->setUsed(declUsed);
-		ret = new BlockItem(decl);
-	} else if (state != NULL) {
-		source->setUsed(stateUsed);
-		ret = new BlockItem(state);
-	} else {
-		source->setUsed(bufferUsed);
-		ret = NULL;
 	}
-	return ret;
 }
 
 
@@ -325,7 +332,7 @@ ExpressionStatement* Parser :: parseExpressionStatement() {
 	Expression* expr = NULL;
 	expr = parseExpression();
 	Token after = source->get();
-	if (after.getName() != ";") {
+	if (after.getSymbol() != SYM_SEMICOLON) {
 		return new ExpressionStatement(NULL);
 	}
 	return new ExpressionStatement(expr);
@@ -406,7 +413,7 @@ JumpStatement* Parser :: parseJumpStatement() {
 		throw new SyntaxException(err);
 	}
 	current = source->get();
-	if (current.getName() != ";") {
+	if (current.getSymbol() != SYM_SEMICOLON) {
 		string err = "Expected ';' after jump statement";
 		throw new SyntaxException(err);
 	}
@@ -418,11 +425,11 @@ LabeledStatement* Parser :: parseLabeledStatement() {
 	Token first = source->get();
 	if (first.getKey() == KEYWORD || first.getKey() == IDENTIFIER) {
 		Expression* constExpr = NULL;
-		if (source->peek().getName() == ":") {
+		if (source->peek().getSymbol() == SYM_COLON) {
 			//No constant expression
 		} else {
 			constExpr = parseExpression(CONDITIONAL);
-			if (source->peek().getName() != ":") {
+			if (source->peek().getSymbol() != SYM_COLON) {
 				return NULL;
 			}
 		}
@@ -436,11 +443,11 @@ LabeledStatement* Parser :: parseLabeledStatement() {
 IterationStatement* Parser :: parseIterationStatement() {
 	Token token = source->peek();
 	IterationStatement* ret = NULL;
-	if (token.getName() == "while") {
+	if (token.getSymbol() == SYM_WHILE) {
 		ret = parseWhileStatement();
-	} else if (token.getName() == "do") {
+	} else if (token.getSymbol() == SYM_DO) {
 		ret = parseDoWhileStatement();
-	} else if (token.getName() == "for") {
+	} else if (token.getSymbol() == SYM_FOR) {
 		ret = parseForStatement();
 	}
 	return ret;
@@ -448,18 +455,18 @@ IterationStatement* Parser :: parseIterationStatement() {
 
 WhileStatement* Parser :: parseWhileStatement() {
 	Token token = source->get();
-	if (token.getName() != "while") {
+	if (token.getSymbol() != SYM_WHILE) {
 		string err = "Expected 'while'";
 		throw new SyntaxException(err);
 	}
 	token = source->get();
-	if (token.getName() != "(") {
+	if (token.getSymbol() != SYM_LPAREN) {
 		string err = "Expected '('";
 		throw new SyntaxException(err);
 	}
 	Expression* expr = parseExpression();
 	token = source->get();
-	if (token.getName() != ")") {
+	if (token.getSymbol() != SYM_RPAREN) {
 		string err = "Expected ')'";
 		throw new SyntaxException(err);
 	}
@@ -469,24 +476,24 @@ WhileStatement* Parser :: parseWhileStatement() {
 
 DoWhileStatement* Parser :: parseDoWhileStatement() {
 	Token token = source->get();
-	if (token.getName() != "do") {
+	if (token.getSymbol() != SYM_DO) {
 		string err = "Expected 'do'";
 		throw new SyntaxException(err);
 	}
 	Statement* state = parseStatement();
 	token = source->get();
-	if (token.getName() != "while") {
+	if (token.getSymbol() != SYM_WHILE) {
 		string err = "Expected 'while'";
 		throw new SyntaxException(err);
 	}
 	token = source->get();
-	if (token.getName() != "(") {
+	if (token.getSymbol() != SYM_LPAREN) {
 		string err = "Expected '('";
 		throw new SyntaxException(err);
 	}
 	Expression* expr = parseExpression();
 	token = source->get();
-	if (token.getName() != ")") {
+	if (token.getSymbol() != SYM_RPAREN) {
 		string err = "Expected ')'";
 		throw new SyntaxException(err);
 	}
@@ -495,31 +502,31 @@ DoWhileStatement* Parser :: parseDoWhileStatement() {
 
 ForStatement* Parser :: parseForStatement() {
 	Token token = source->get();
-	if (token.getName() != "for") {
+	if (token.getSymbol() != SYM_FOR) {
 		string err = "Expected 'for'";
 		throw new SyntaxException(err);
 	}
 	token = source->get();
-	if (token.getName() != "(") {
+	if (token.getSymbol() != SYM_LPAREN) {
 		string err = "Expected '('";
 		throw new SyntaxException(err);
 	}
 	token = source->peek();
 	Expression* first = NULL;
-	if (token.getName() == ";") {
+	if (token.getSymbol() == SYM_SEMICOLON) {
 		//Omitted first expression
 		source->get();
 	} else {
 		first = parseExpression(); //TODO:support declarations here
 	}
 	token = source->get();
-	if (token.getName() != ";") {
+	if (token.getSymbol() != SYM_SEMICOLON) {
 		string err = "Expected ';'";
 		throw new SyntaxException(err);
 	}
 	token = source->peek();
 	Expression* second = NULL;
-	if (token.getName() == ";") {
+	if (token.getSymbol() == SYM_SEMICOLON) {
 		//Omitted second expression is replaced with non-zero constant
 		//Here, non-zero means 1
 		source->get();
@@ -529,14 +536,14 @@ ForStatement* Parser :: parseForStatement() {
 	}
 	token = source->get();
 	Expression* third = NULL;
-	if (token.getName() == ")") {
+	if (token.getSymbol() == SYM_RPAREN) {
 		//Omitted third expression
 		source->get();
 	} else {
 		third = parseExpression();
 	}
 	token = source->get();
-	if (token.getName() != ")") {
+	if (token.getSymbol() != SYM_RPAREN) {
 		string err = "Expected ')'";
 		throw new SyntaxException(err);
 	}
@@ -545,38 +552,47 @@ ForStatement* Parser :: parseForStatement() {
 	return new ForStatement(first, second, third, state);
 }
 
+//! Parses declaration specifiers for as long as there are any
+/*! Once a specifier has given the type, an identifier is what is declared,
+ * even if it is a typedef name, as in 'T T;' in an inner scope.
+ */
 DeclarationSpecifierList* Parser :: parseDeclarationSpecifierList() {
 	DeclarationSpecifierList* ret = NULL;
-	DeclarationSpecifier* current;
-	current = parseDeclarationSpecifier();
-	if (current != NULL) {
-		//Recursion!
-		ret = new DeclarationSpecifierList(current, parseDeclarationSpecifierList());
-	} else {
-		ret = NULL;
+	DeclarationSpecifier* current = NULL;
+	bool typed = false;
+	while ((current = parseDeclarationSpecifier(!typed)) != NULL) {
+		if (ret == NULL) {
+			ret = new DeclarationSpecifierList(current);
+		} else {
+			ret->add(current);
+		}
+		typed = typed || (dynamic_cast<StorageClassSpecifier*>(current) == NULL \
+				&& dynamic_cast<TypeQualifier*>(current) == NULL && \
+				dynamic_cast<FunctionSpecifier*>(current) == NULL && \
+				dynamic_cast<AlignmentSpecifier*>(current) == NULL);
 	}
 	return ret;
 }
 
-DeclarationSpecifier* Parser :: parseDeclarationSpecifier() {
+DeclarationSpecifier* Parser :: parseDeclarationSpecifier(bool typedefName) {
 	//TODO: Implement struct-or-union-specifiers
 	DeclarationSpecifier* ret = NULL;
 	//Storage class specifiers
 	Token token = source->peek();
-	auto search = this->mStorageClassSpecifier.find(token.getName());
+	auto search = this->mStorageClassSpecifier.find(token.getSymbol());
 	if (search != this->mStorageClassSpecifier.end()) {
 		return parseStorageClassSpecifier();
 	}
 	//Function specifiers
-	search = this->mFunctionSpecifier.find(token.getName());
+	search = this->mFunctionSpecifier.find(token.getSymbol());
 	if (search != this->mFunctionSpecifier.end()) {
 		return parseFunctionSpecifier();
 	}
 	//Type Qualifiers
-	search = this->mTypeQualifier.find(token.getName());
+	search = this->mTypeQualifier.find(token.getSymbol());
 	if (search != this->mTypeQualifier.end()) {
-		if (token.getName() == "_Atomic") {
-			if (source->peek(1).getName() == "(") {
+		if (token.getSymbol() == SYM_ATOMIC) {
+			if (source->peek(1).getSymbol() == SYM_LPAREN) {
 			} else {
 				return parseTypeQualifier();
 			}
@@ -585,21 +601,21 @@ DeclarationSpecifier* Parser :: parseDeclarationSpecifier() {
 		}
 	}
 	//Type Specifiers
-	search = this->mTypeSpecifier.find(token.getName());
+	search = this->mTypeSpecifier.find(token.getSymbol());
 	if (search != this->mTypeSpecifier.end()) {
-		if (token.getName() == "_Atomic") {
+		if (token.getSymbol() == SYM_ATOMIC) {
 			//If _Atomic, make there's a pair of parenthesis after,
 			//otherwise do nothing (is TypeQualifier instead)
-			if (source->peek(1).getName() == "(") {
+			if (source->peek(1).getSymbol() == SYM_LPAREN) {
 				return parseTypeSpecifier();
 			}
 		//Struct or Union Specifiers
-		} else if (token.getName() == "struct") {
+		} else if (token.getSymbol() == SYM_STRUCT) {
 			source->get();
 			ret = new StructSpecifier(token);
 			ret->parse(this);
 			return ret;
-		} else if (token.getName() == "union") {
+		} else if (token.getSymbol() == SYM_UNION) {
 			source->get();
 			ret = new UnionSpecifier(token);
 			ret->parse(this);
@@ -609,17 +625,22 @@ DeclarationSpecifier* Parser :: parseDeclarationSpecifier() {
 		}
 	}
 	//Alignment Specifiers
-	search = this->mAlignmentSpecifier.find(token.getName());
+	search = this->mAlignmentSpecifier.find(token.getSymbol());
 	if (search != this->mAlignmentSpecifier.end()) {
 		return parseAlignmentSpecifier();
 	}
+	//Typedef names
+	if (typedefName && this->mTypedefName.count(token.getSymbol()) > 0) {
+		source->get();
+		return new TypeSpecifier(token);
+	}
 
 	//Struct or Union Specifiers
-	if (token.getName() == "struct") {
+	if (token.getSymbol() == SYM_STRUCT) {
 		ret = new StructSpecifier(token);
 		ret->parse(this);
 		return ret;
-	} else if (token.getName() == "union") {
+	} else if (token.getSymbol() == SYM_UNION) {
 		ret = new UnionSpecifier(token);
 		ret->parse(this);
 		return ret;
@@ -631,7 +652,7 @@ DeclarationSpecifier* Parser :: parseDeclarationSpecifier() {
 StorageClassSpecifier* Parser :: parseStorageClassSpecifier() {
 	StorageClassSpecifier* ret = NULL;
 	Token token = source->get();
-	auto search = this->mStorageClassSpecifier.find(token.getName());
+	auto search = this->mStorageClassSpecifier.find(token.getSymbol());
 	if (search != this->mStorageClassSpecifier.end()) {
 		ret = new StorageClassSpecifier(token);
 		ret->parse(this);
@@ -643,13 +664,14 @@ TypeSpecifier* Parser :: parseTypeSpecifier() {
 	//TODO: Add typedef'd types
 	TypeSpecifier* ret = NULL;
 	Token token = source->get();
-	auto search = this->mTypeSpecifier.find(token.getName());
+	auto search = this->mTypeSpecifier.find(token.getSymbol());
 	if (search != this->mTypeSpecifier.end()) {
-		if (token.getName() == "_Atomic") {
+		if (token.getSymbol() == SYM_ATOMIC) {
 			ret = new AtomicTypeSpecifier(token);
-		} else if (token.getName() == "enum") {
+		} else if (token.getSymbol() == SYM_ENUM) {
 			ret = new EnumTypeSpecifier(token);
-		} else if (token.getName() == "struct" || token.getName() == "union") {
+		} else if (token.getSymbol() == SYM_STRUCT || \
+				token.getSymbol() == SYM_UNION) {
 
 		} else {
 			ret = new TypeSpecifier(token);
@@ -662,12 +684,16 @@ TypeSpecifier* Parser :: parseTypeSpecifier() {
 EnumeratorList* Parser :: parseEnumeratorList() {
 	EnumeratorList* ret = NULL;
 	Token token = source->get();
-	if (token.getName() != "," && token.getName() != "}") {
-		ret = new EnumeratorList(new Enumerator(token), parseEnumeratorList());
-	} else if (token.getName() == ",") {
-		ret = parseEnumeratorList();
-	} else if (token.getName() == "}") {
-		ret = NULL;
+	while (token.getSymbol() != SYM_RBRACE) {
+		if (token.getSymbol() != SYM_COMMA) {
+			Enumerator* item = new Enumerator(token);
+			if (ret == NULL) {
+				ret = new EnumeratorList(item);
+			} else {
+				ret->add(item);
+			}
+		}
+		token = source->get();
 	}
 	return ret;
 }
@@ -675,7 +701,7 @@ EnumeratorList* Parser :: parseEnumeratorList() {
 TypeQualifier* Parser :: parseTypeQualifier() {
 	TypeQualifier* ret = NULL;
 	Token token = source->get();
-	auto search = mTypeQualifier.find(token.getName());
+	auto search = mTypeQualifier.find(token.getSymbol());
 	if (search != mTypeQualifier.end()) {
 		ret = new TypeQualifier(token);
 	}
@@ -685,7 +711,7 @@ TypeQualifier* Parser :: parseTypeQualifier() {
 FunctionSpecifier* Parser :: parseFunctionSpecifier() {
 	FunctionSpecifier* ret = NULL;
 	Token token = source->get();
-	auto search = mFunctionSpecifier.find(token.getName());
+	auto search = mFunctionSpecifier.find(token.getSymbol());
 	if (search != mFunctionSpecifier.end()) {
 		ret = new FunctionSpecifier(token);
 	}
@@ -695,7 +721,7 @@ FunctionSpecifier* Parser :: parseFunctionSpecifier() {
 AlignmentSpecifier* Parser :: parseAlignmentSpecifier() {
 	AlignmentSpecifier* ret = NULL;
 	Token token = source->get();
-	auto search = mAlignmentSpecifier.find(token.getName());
+	auto search = mAlignmentSpecifier.find(token.getSymbol());
 	if (search != mAlignmentSpecifier.end()) {
 		ret = new AlignmentSpecifier(token);
 		ret->parse(this);
@@ -706,9 +732,9 @@ AlignmentSpecifier* Parser :: parseAlignmentSpecifier() {
 DeclarationSpecifier* Parser :: parseStructOrUnionSpecifier() {
 	DeclarationSpecifier* ret = NULL;
 	Token token = source->get();
-	if (token.getName() == "struct") {
+	if (token.getSymbol() == SYM_STRUCT) {
 		ret = new StructSpecifier(token);
-	} else if (token.getName() == "union") {
+	} else if (token.getSymbol() == SYM_UNION) {
 		ret = new UnionSpecifier(token);
 	} else {
 		ret = NULL;
@@ -718,22 +744,24 @@ DeclarationSpecifier* Parser :: parseStructOrUnionSpecifier() {
 	} return ret;
 }
 
-SpecifierQualifierList* Parser :: parseSpecifierQualifierList() {
+//! Parses the specifiers of a member, typed once one of them gave the type
+SpecifierQualifierList* Parser :: parseSpecifierQualifierList(bool typed) {
 	SpecifierQualifierList* ret = NULL;
 	SpecifierQualifierList* next = NULL;
 	Token token = source->peek();
-	auto search = mTypeSpecifier.find(token.getName());
-	if (search != mTypeSpecifier.end()) {
+	auto search = mTypeSpecifier.find(token.getSymbol());
+	if (search != mTypeSpecifier.end() || \
+			(!typed && mTypedefName.count(token.getSymbol()) > 0)) {
 		source->get();
 		TypeSpecifier* spec = new TypeSpecifier(token);
-		next = parseSpecifierQualifierList();
+		next = parseSpecifierQualifierList(true);
 		return new SpecifierQualifierList(spec, next);
 	}
-	search = mTypeQualifier.find(token.getName());
+	search = mTypeQualifier.find(token.getSymbol());
 	if (search != mTypeQualifier.end()) {
 		source->get();
 		TypeQualifier* qual = new TypeQualifier(token);
-		next = parseSpecifierQualifierList();
+		next = parseSpecifierQualifierList(typed);
 		return new SpecifierQualifierList(qual, next);
 	}
 	return ret;
@@ -742,7 +770,7 @@ SpecifierQualifierList* Parser :: parseSpecifierQualifierList() {
 StructDeclarator* Parser :: parseStructDeclarator() {
 	Declarator* decl = parseDeclarator();
 	Expression* expr = NULL;
-	if (source->peek().getName() == ":") {
+	if (source->peek().getSymbol() == SYM_COLON) {
 		source->get();
 		expr = parseExpression(CONDITIONAL);
 	} else if (decl == NULL) {
@@ -752,13 +780,13 @@ StructDeclarator* Parser :: parseStructDeclarator() {
 }
 
 StructDeclaratorList* Parser :: parseStructDeclaratorList() {
-	StructDeclaratorList* ret = NULL;
 	StructDeclarator* item = parseStructDeclarator();
 	if (item == NULL) {
-		ret = NULL;
-	} else {
-		StructDeclaratorList* next = parseStructDeclaratorList();
-		ret = new StructDeclaratorList(item, next);
+		return NULL;
+	}
+	StructDeclaratorList* ret = new StructDeclaratorList(item);
+	while ((item = parseStructDeclarator()) != NULL) {
+		ret->add(item);
 	}
 	return ret;
 }
@@ -766,7 +794,7 @@ StructDeclaratorList* Parser :: parseStructDeclaratorList() {
 StructDeclaration* Parser :: parseStructDeclaration() {
 	SpecifierQualifierList* specQualList = parseSpecifierQualifierList();
 	StructDeclaratorList* structDeclList = parseStructDeclaratorList();
-	if (source->peek().getName() == ";") {
+	if (source->peek().getSymbol() == SYM_SEMICOLON) {
 		source->get();
 		return new StructDeclaration(specQualList, structDeclList);
 	} else if (specQualList == NULL) {
@@ -776,13 +804,13 @@ StructDeclaration* Parser :: parseStructDeclaration() {
 }
 
 StructDeclarationList* Parser :: parseStructDeclarationList() {
-	StructDeclarationList* ret = NULL;
 	StructDeclaration* item = parseStructDeclaration();
 	if (item == NULL) {
-		ret = NULL;
-	} else {
-		StructDeclarationList* next = parseStructDeclarationList();
-		ret = new StructDeclarationList(item, next);
+		return NULL;
+	}
+	StructDeclarationList* ret = new StructDeclarationList(item);
+	while ((item = parseStructDeclaration()) != NULL) {
+		ret->add(item);
 	}
 	return ret;
 }
@@ -798,11 +826,10 @@ Expression* Parser :: parseExpression() {
 }
 
 Expression* Parser :: parseExpression(PriorityEnum priority) {
-	Expression* ret = NULL;
 	Token token = source->get();
-	auto searchPrefix = mPrefix.find(token.getName());
+	const OperatorEntry& prefix = this->findOperator(token.getSymbol());
 	Expression* left = NULL;
-	if (token.getName() == "(") {
+	if (token.getSymbol() == SYM_LPAREN) {
 		if (source->peek().getKey() == KEYWORD) {
 			//Sould be a type cast
 			left = new TypeCast(this);
@@ -811,14 +838,14 @@ Expression* Parser :: parseExpression(PriorityEnum priority) {
 			//Normal parenthesis, look for expression (DEFAULT priority) inside
 			left = parseExpression();
 			token = source->get();
-			if (token.getName() != ")") {
+			if (token.getSymbol() != SYM_RPAREN) {
 				string err = "Expected ')'";
 				throw new SyntaxException(err);
 			}
 		}
-	} else if (searchPrefix != mPrefix.end()) {
+	} else if (prefix.prefix != NULL) {
 		//Found current token as prefix operator
-			left = searchPrefix->second(this);
+			left = prefix.prefix(this);
 			left->parse(this);
 	} else if (token.getKey() == KEYWORD) {
 		left = new KeywordExpression(token);
@@ -832,30 +859,16 @@ Expression* Parser :: parseExpression(PriorityEnum priority) {
 		string err = "Could not parse '" + token.getName() + "'";
 	}
 	
-	token = source->peek();
-	auto searchInfix = mInfix.find(token.getName());
-	if (searchInfix != mInfix.end()) {
-		//Found current token as infix operator
-		Expression* dummy = searchInfix->second(this, NULL);
-		//Reset buffer after unecessary parsing performed by the initializer of dummy
-		while (searchInfix != mInfix.end() && \
-				priority < dummy->getPriority()) {
-			source->get(); //Actually consume the peeked token
-			left = searchInfix->second(this, left);
-			left->parse(this);
-			token = source->peek();
-			searchInfix = mInfix.find(token.getName());
-			delete dummy;
-			if (searchInfix != mInfix.end()) {
-				dummy = searchInfix->second(this,NULL);
-			}
-		}
-		ret = left;
-	} else {
-		//No infix here, so just return the prefix parsing
-		ret = left;
+	//Infix operators binding tighter than the priority are applied to the
+	//left operand, those which do not are left for a caller
+	const OperatorEntry* infix = &this->findOperator(source->peek().getSymbol());
+	while (priority < infix->priority) {
+		source->get(); //Actually consume the peeked token
+		left = infix->infix(this, left);
+		left->parse(this);
+		infix = &this->findOperator(source->peek().getSymbol());
 	}
-	return ret;
+	return left;
 }
 
 Identifier* Parser :: parseIdentifier() {
@@ -871,7 +884,7 @@ Identifier* Parser :: parseIdentifier() {
 Declarator* Parser :: parseDeclarator() {
 	Declarator* ret = NULL;
 	Pointer* ptr = NULL;
-	if (source->peek().getName() == "*") {
+	if (source->peek().getSymbol() == SYM_STAR) {
 		ptr = parsePointer();
 	}
 	DirectDeclarator* dirDecl = NULL;
@@ -892,28 +905,29 @@ Declarator* Parser :: parseDeclarator() {
 Pointer* Parser :: parsePointer() {
 	Pointer* ret = NULL;
 	Token token = source->peek();
-	if (token.getName() != "*") {
+	if (token.getSymbol() != SYM_STAR) {
 		return NULL;
 	}
 	source->get();
-	unsigned int bufferUsed = source->bufferSize();
+	Checkpoint<Token> beforeQualifiers = source->mark();
 	TypeQualifierList* typeQualList = parseTypeQualifierList();
 	if (typeQualList == NULL) {
-		source->setUsed(bufferUsed);
+		beforeQualifiers.rewind();
 	}
+	beforeQualifiers.commit();
 	Pointer* next = parsePointer();
 	ret = new Pointer(typeQualList, next);
 	return ret;
 }
 
 TypeQualifierList* Parser :: parseTypeQualifierList() {
-	TypeQualifierList* ret = NULL;
 	TypeQualifier* item = parseTypeQualifier();
 	if (item == NULL) {
-		ret = NULL;
-	} else {
-		TypeQualifierList* next = parseTypeQualifierList();
-		ret = new TypeQualifierList(item, next);
+		return NULL;
+	}
+	TypeQualifierList* ret = new TypeQualifierList(item);
+	while ((item = parseTypeQualifier()) != NULL) {
+		ret->add(item);
 	}
 	return ret;
 }
@@ -922,49 +936,45 @@ DirectDeclarator* Parser :: parseDirectDeclarator() {
 	//TODO: Expand when DirectDeclarator has been expanded
 	DirectDeclarator* ret = NULL;
 	Token peek = source->peek();
-	if (peek.getName() == "(") {
+	if (peek.getSymbol() == SYM_LPAREN) {
 		//Can be Declarator, ParameterTypeList, or IdentifierList
 		//Currently only Declarator is implemented
 		source->get();
-		unsigned int bufferBefore = source->bufferSize();
+		Checkpoint<Token> before = source->mark();
+		//Where each parse ended, where it began if it failed
 		Declarator* decl = parseDeclarator();
-		unsigned int declUsed = source->bufferSize();
-		if (decl == NULL) {
-			declUsed = bufferBefore;
-		}
+		size_t declUsed = (decl == NULL) ? before.getPosition() : \
+						  source->offset();
 		
-		source->setUsed(bufferBefore);
+		before.rewind();
 		ParameterTypeList* paramTypeList = parseParameterTypeList();
-		unsigned int paramUsed = source->bufferSize();
-		if (paramTypeList == NULL) {
-			paramUsed = bufferBefore;
-		}
+		size_t paramUsed = (paramTypeList == NULL) ? before.getPosition() : \
+						   source->offset();
 
-		source->setUsed(bufferBefore);
+		before.rewind();
 		IdentifierList* idList = parseIdentifierList();
-		unsigned int idListUsed = source->bufferSize();
-		if (idList == NULL) {
-			idListUsed = bufferBefore;
-		}
+		size_t idListUsed = (idList == NULL) ? before.getPosition() : \
+							source->offset();
 		
 		if (declUsed > paramUsed) {
 			if (declUsed > idListUsed) {
 				ret = new DeclaratorDirectDeclarator(decl);
-				source->setUsed(declUsed);
+				source->seek(declUsed);
 			} else {
 				ret = new IdentifierListDirectDeclarator(idList);
-				source->setUsed(idListUsed);
+				source->seek(idListUsed);
 			}
 		} else {
 			if (paramUsed > idListUsed) {
 				ret = new ParameterTypeListDirectDeclarator(paramTypeList);
-				source->setUsed(paramUsed);
+				source->seek(paramUsed);
 			} else {
 				ret = new IdentifierListDirectDeclarator(idList);
-				source->setUsed(idListUsed);
+				source->seek(idListUsed);
 			}
 		}
-		if (source->get().getName() != ")") {
+		before.commit();
+		if (source->get().getSymbol() != SYM_RPAREN) {
 			//string err = "Expected ')'";
 			//throw new SyntaxException(err);
 			ret = NULL;
@@ -987,14 +997,15 @@ IdentifierList* Parser :: parseIdentifierList() {
 		id = parseIdentifier();
 	}
 	if (id == NULL) {
-		ret = NULL;
-	} else {
-		if (source->peek().getName() == ",") {
-			source->get();
-			ret = new IdentifierList(id, parseIdentifierList());
-		} else {
-			ret = new IdentifierList(id);
+		return NULL;
+	}
+	ret = new IdentifierList(id);
+	while (source->peek().getSymbol() == SYM_COMMA) {
+		source->get();
+		if (source->peek().getKey() != IDENTIFIER) {
+			break;
 		}
+		ret->add(parseIdentifier());
 	}
 	return ret;
 }
@@ -1002,10 +1013,10 @@ IdentifierList* Parser :: parseIdentifierList() {
 ParameterTypeList* Parser :: parseParameterTypeList() {
 	ParameterTypeList* ret = NULL;
 	ParameterList* paramList = parseParameterList();
-	if (source->peek().getName() == ",") {
+	if (source->peek().getSymbol() == SYM_COMMA) {
 		source->get();
 		int i = 0;
-		while (source->get().getName() == "." && i < 3) {
+		while (source->get().getSymbol() == SYM_DOT && i < 3) {
 			++i;
 		}
 		//If some dot not found
@@ -1024,18 +1035,17 @@ ParameterTypeList* Parser :: parseParameterTypeList() {
 }
 
 ParameterList* Parser :: parseParameterList() {
-	ParameterList* ret = NULL;
-	ParameterDeclaration* paramDecl = NULL;
-	paramDecl = parseParameterDeclaration();
+	ParameterDeclaration* paramDecl = parseParameterDeclaration();
 	if (paramDecl == NULL) {
-		ret = NULL;
-	} else {
-		if (source->peek().getName() == ",") {
-			source->get();
-			ret = new ParameterList(paramDecl, parseParameterList());
-		} else {
-			ret = new ParameterList(paramDecl);
+		return NULL;
+	}
+	ParameterList* ret = new ParameterList(paramDecl);
+	while (source->peek().getSymbol() == SYM_COMMA) {
+		source->get();
+		if ((paramDecl = parseParameterDeclaration()) == NULL) {
+			break;
 		}
+		ret->add(paramDecl);
 	}
 	return ret;
 }
@@ -1056,10 +1066,11 @@ Declaration* Parser :: parseDeclaration() {
 	try {
 		initList = parseInitDeclaratorList();
 		Token token = source->peek(); //TODO: Check if this is okay
-		if (token.getName() != ";") {
+		if (token.getSymbol() != SYM_SEMICOLON) {
 			return NULL;
 		} else {
 			source->get();
+			this->addTypedefNames(declList, initList);
 		}
 	} catch (InitDeclaratorListException) {
 		//No problem, since the list is optional
@@ -1074,28 +1085,40 @@ Declaration* Parser :: parseDeclaration() {
 }
 
 DeclarationList* Parser :: parseDeclarationList() {
-	DeclarationList* list = NULL;
 	Declaration* item = parseDeclaration();
-	if (item != NULL) {
-		list = new DeclarationList(item, parseDeclarationList());
+	if (item == NULL) {
+		return NULL;
+	}
+	DeclarationList* list = new DeclarationList(item);
+	while ((item = parseDeclaration()) != NULL) {
+		list->add(item);
 	}
 	return list;
 }
 
 InitDeclaratorList* Parser :: parseInitDeclaratorList() {
-	InitDeclarator* first = NULL;
+	InitDeclaratorList* ret = NULL;
+	try {
+		ret = new InitDeclaratorList(parseInitDeclarator());
+	} catch (InitDeclaratorException) {
+		string err = "Could not parse init declarator in init declarator list";
+		throw new InitDeclaratorListException(err);
+	}
+	parseInitDeclarators(ret);
+	return ret;
+}
+
+//! Adds each init declarator which follows a ',' to the list
+void Parser :: parseInitDeclarators(InitDeclaratorList* list) {
 	try {
-		first = parseInitDeclarator();
-		Token after = source->peek();
-		if (after.getName() == ",") {
+		while (source->peek().getSymbol() == SYM_COMMA) {
 			source->get();
-			return new InitDeclaratorList(first, parseInitDeclaratorList());
+			list->add(parseInitDeclarator());
 		}
 	} catch (InitDeclaratorException) {
 		string err = "Could not parse init declarator in init declarator list";
 		throw new InitDeclaratorListException(err);
 	}
-	return new InitDeclaratorList(first);
 }
 
 InitDeclarator* Parser :: parseInitDeclarator() {
@@ -1108,7 +1131,7 @@ InitDeclarator* Parser :: parseInitDeclarator() {
 		string err = "Could not parse declarator in init declarator";
 		throw new InitDeclaratorException(err);
 	}
-	if (source->peek().getName() == "=") {
+	if (source->peek().getSymbol() == SYM_ASSIGN) {
 		source->get();
 		init = parseInitializer();
 	}
@@ -1116,6 +1139,18 @@ InitDeclarator* Parser :: parseInitDeclarator() {
 	return ret;
 }
 
+//! The rest of an init declarator list, after its first declarator
+InitDeclaratorList* Parser :: parseInitDeclaratorList(Declarator* first) {
+	Initializer* init = NULL;
+	if (source->peek().getSymbol() == SYM_ASSIGN) {
+		source->get();
+		init = parseInitializer();
+	}
+	InitDeclaratorList* ret = new InitDeclaratorList(new InitDeclarator(first, init));
+	parseInitDeclarators(ret);
+	return ret;
+}
+
 Initializer* Parser :: parseInitializer() {
 	//TODO: Implement initializer-lists
 	Expression* expr = parseExpression(ASSIGNMENT);
@@ -1123,114 +1158,131 @@ Initializer* Parser :: parseInitializer() {
 }
 
 ArgumentList* Parser :: parseArgumentList() {
-	Expression* expr = parseExpression(ASSIGNMENT);
-	if (source->peek().getName() == ",") {
+	ArgumentList* ret = new ArgumentList(parseExpression(ASSIGNMENT));
+	while (source->peek().getSymbol() == SYM_COMMA) {
 		source->get();
-		return new ArgumentList(expr, parseArgumentList());
-	} else {
-		return new ArgumentList(expr, NULL);
+		ret->add(parseExpression(ASSIGNMENT));
 	}
+	return ret;
 }
 
+enum Associativity {LEFT, RIGHT};
+
+//! The operators of C11 and how each of them is parsed
+/*! The priority is that of the infix operator, the prefix operators give
+ * theirs to PrefixOperator. A token which is both, like '-', is one entry.
+ * '(' as a prefix is a cast or parenthesis, see parseExpression().
+ */
+static const struct {
+	const char* name;
+	PriorityEnum priority;
+	Associativity associativity;
+	Parser::PrefixFactory prefix;
+	Parser::InfixFactory infix;
+} c11OperatorTable[] = {
+	{"++", POSTFIX, LEFT, (Parser::PrefixFactory) IncrementPrefix::create, (Parser::InfixFactory) IncrementPostfix::create},
+	{"--", POSTFIX, LEFT, (Parser::PrefixFactory) DecrementPrefix::create, (Parser::InfixFactory) DecrementPostfix::create},
+	{"->", POSTFIX, LEFT, NULL, (Parser::InfixFactory) StructureDereference::create},
+	{".", POSTFIX, LEFT, NULL, (Parser::InfixFactory) StructureReference::create},
+	{",", COMMA, LEFT, NULL, (Parser::InfixFactory) Comma::create},
+	{"=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) StandardAssignment::create},
+	{"*=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) MultiplicationAssignment::create},
+	{"/=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) DivisionAssignment::create},
+	{"%=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) ModuloAssignment::create},
+	{"+=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) AdditionAssignment::create},
+	{"-=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) SubtractionAssignment::create},
+	{"<<=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) LeftShiftAssignment::create},
+	{">>=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) RightShiftAssignment::create},
+	{"&=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) AddressAssignment::create},
+	{"^=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) XORAssignment::create},
+	{"|=", ASSIGNMENT, RIGHT, NULL, (Parser::InfixFactory) ORAssignment::create},
+	{"||", LOGICAL_OR, LEFT, NULL, (Parser::InfixFactory) LogicalOR::create},
+	{"&&", LOGICAL_AND, LEFT, NULL, (Parser::InfixFactory) LogicalAND::create},
+	{"|", BITWISE_OR, LEFT, NULL, (Parser::InfixFactory) BitwiseOR::create},
+	{"^", BITWISE_XOR, LEFT, NULL, (Parser::InfixFactory) BitwiseXOR::create},
+	{"&", BITWISE_AND, LEFT, (Parser::PrefixFactory) Reference::create, (Parser::InfixFactory) BitwiseAND::create},
+	{"==", EQUALITY, LEFT, NULL, (Parser::InfixFactory) Equality::create},
+	{"!=", EQUALITY, LEFT, NULL, (Parser::InfixFactory) NonEquality::create},
+	{"<", RELATIONAL, LEFT, NULL, (Parser::InfixFactory) LessThan::create},
+	{">", RELATIONAL, LEFT, NULL, (Parser::InfixFactory) GreaterThan::create},
+	{"<=", RELATIONAL, LEFT, NULL, (Parser::InfixFactory) LessThanOrEqual::create},
+	{">=", RELATIONAL, LEFT, NULL, (Parser::InfixFactory) GreaterThanOrEqual::create},
+	{"<<", SHIFT, LEFT, NULL, (Parser::InfixFactory) ShiftLeft::create},
+	{">>", SHIFT, LEFT, NULL, (Parser::InfixFactory) ShiftRight::create},
+	{"+", ADDITIVE, LEFT, (Parser::PrefixFactory) UnaryPlus::create, (Parser::InfixFactory) Addition::create},
+	{"-", ADDITIVE, LEFT, (Parser::PrefixFactory) UnaryMinus::create, (Parser::InfixFactory) Subtraction::create},
+	{"*", MULTIPLICATIVE, LEFT, (Parser::PrefixFactory) Indirection::create, (Parser::InfixFactory) Multiplication::create},
+	{"/", MULTIPLICATIVE, LEFT, NULL, (Parser::InfixFactory) Division::create},
+	{"%", MULTIPLICATIVE, LEFT, NULL, (Parser::InfixFactory) Modulo::create},
+	{"[", POSTFIX, LEFT, NULL, (Parser::InfixFactory) ArraySubscript::create},
+	{"(", POSTFIX, LEFT, NULL, (Parser::InfixFactory) FunctionCall::create},
+	{"?", CONDITIONAL, RIGHT, NULL, (Parser::InfixFactory) ConditionalExpression::create},
+	{"~", DEFAULT, LEFT, (Parser::PrefixFactory) BitwiseNOT::create, NULL},
+	{"!", DEFAULT, LEFT, (Parser::PrefixFactory) LogicalNOT::create, NULL},
+	{"sizeof", DEFAULT, LEFT, (Parser::PrefixFactory) Sizeof::create, NULL},
+	{"_Alignof", DEFAULT, LEFT, (Parser::PrefixFactory) Alignof::create, NULL},
+	{"_Generic", DEFAULT, LEFT, (Parser::PrefixFactory) Generic::create, NULL},
+};
+
 void Parser :: c11Operators() {
-	//Prefix
-	this->mPrefix["+"] = (Operator* (*)(Parser*)) UnaryPlus::create;
-	this->mPrefix["-"] = (Operator* (*)(Parser*)) UnaryMinus::create;
-	this->mPrefix["&"] = (Operator* (*)(Parser*)) Reference::create;
-	this->mPrefix["*"] = (Operator* (*)(Parser*)) Indirection::create;
-	this->mPrefix["~"] = (Operator* (*)(Parser*)) BitwiseNOT::create;
-	this->mPrefix["!"] = (Operator* (*)(Parser*)) LogicalNOT::create;
-	this->mPrefix["++"] = (Operator* (*)(Parser*)) IncrementPrefix::create;
-	this->mPrefix["--"] = (Operator* (*)(Parser*)) DecrementPrefix::create;
-	this->mPrefix["sizeof"] = (Operator* (*)(Parser*)) Sizeof::create;
-	this->mPrefix["_Alignof"] = (Operator* (*)(Parser*)) Alignof::create;
-	this->mPrefix["_Generic"] = (Operator* (*)(Parser*)) Generic::create;
-		
-	//Postfix
-	this->mInfix["++"] = (InfixOperator* (*)(Parser*, Expression*)) IncrementPostfix::create;
-	this->mInfix["--"] = (InfixOperator* (*)(Parser*, Expression*)) DecrementPostfix::create;
-	this->mInfix["->"] = (InfixOperator* (*)(Parser*, Expression*)) StructureDereference::create;
-	this->mInfix["."] = (InfixOperator* (*)(Parser*, Expression*)) StructureReference::create;
-	
-	
-	//Binary
-	this->mInfix[","] = (InfixOperator* (*)(Parser*, Expression*)) Comma::create;
-	this->mInfix["="] = (InfixOperator *(*)(Parser *, Expression *)) StandardAssignment::create;
-	this->mInfix["*="] = (InfixOperator *(*)(Parser *, Expression *)) MultiplicationAssignment::create;
-	this->mInfix["/="] = (InfixOperator *(*)(Parser *, Expression *)) DivisionAssignment::create;
-	this->mInfix["%="] = (InfixOperator *(*)(Parser *, Expression *)) ModuloAssignment::create;
-	this->mInfix["+="] = (InfixOperator *(*)(Parser *, Expression *)) AdditionAssignment::create;
-	this->mInfix["-="] = (InfixOperator *(*)(Parser *, Expression *)) SubtractionAssignment::create;
-	this->mInfix["<<="] = (InfixOperator *(*)(Parser *, Expression *)) LeftShiftAssignment::create;
-	this->mInfix[">>="] = (InfixOperator *(*)(Parser *, Expression *)) RightShiftAssignment::create;
-	this->mInfix["&="] = (InfixOperator *(*)(Parser *, Expression *)) AddressAssignment::create;
-	this->mInfix["^="] = (InfixOperator *(*)(Parser *, Expression *)) XORAssignment::create;
-	this->mInfix["|="] = (InfixOperator *(*)(Parser *, Expression *)) ORAssignment::create;
-	this->mInfix["||"] = (InfixOperator *(*)(Parser *, Expression *)) LogicalOR::create;
-	this->mInfix["&&"] = (InfixOperator *(*)(Parser *, Expression *)) LogicalAND::create;
-	this->mInfix["|"] = (InfixOperator *(*)(Parser *, Expression *)) BitwiseOR::create;
-	this->mInfix["^"] = (InfixOperator *(*)(Parser *, Expression *)) BitwiseXOR::create;
-	this->mInfix["&"] = (InfixOperator *(*)(Parser *, Expression *)) BitwiseAND::create;
-	this->mInfix["=="] = (InfixOperator *(*)(Parser *, Expression *)) Equality::create;
-	this->mInfix["!="] = (InfixOperator *(*)(Parser *, Expression *)) NonEquality::create;
-	this->mInfix["<"] = (InfixOperator *(*)(Parser *, Expression *)) LessThan::create;
-	this->mInfix[">"] = (InfixOperator *(*)(Parser *, Expression *)) GreaterThan::create;
-	this->mInfix["<="] = (InfixOperator *(*)(Parser *, Expression *)) LessThanOrEqual::create;
-	this->mInfix[">="] = (InfixOperator *(*)(Parser *, Expression *)) GreaterThanOrEqual::create;
-	this->mInfix["<<"] = (InfixOperator *(*)(Parser *, Expression *)) ShiftLeft::create;
-	this->mInfix[">>"] = (InfixOperator *(*)(Parser *, Expression *)) ShiftRight::create;
-	this->mInfix["+"] = (InfixOperator *(*)(Parser *, Expression *)) Addition::create;
-	this->mInfix["-"] = (InfixOperator *(*)(Parser *, Expression *)) Subtraction::create;
-	this->mInfix["*"] = (InfixOperator *(*)(Parser *, Expression *)) Multiplication::create;
-	this->mInfix["/"] = (InfixOperator *(*)(Parser *, Expression *)) Division::create;
-	this->mInfix["%"] = (InfixOperator *(*)(Parser *, Expression *)) Modulo::create;
-	this->mInfix["["] = (InfixOperator *(*)(Parser *, Expression *)) ArraySubscript::create;
-	this->mInfix["("] = (InfixOperator *(*)(Parser *,Expression*)) FunctionCall::create; //This is for function calls, type casts are handled specially along with parenthesis
-	
-	//Ternary
-	this->mInfix["?"] = (InfixOperator *(*)(Parser *, Expression *)) ConditionalExpression::create;
+	this->operators.push_back(OperatorEntry()); //For symbols of no operator
+	for (unsigned int p = DEFAULT; p <= PRIMARY; ++p) {
+		this->operandPriorities[p] = (PriorityEnum) p;
+	}
+	for (const auto& op : c11OperatorTable) {
+		unsigned int symbol = Interner::intern(op.name);
+		if (symbol >= this->operatorIndex.size()) {
+			this->operatorIndex.resize(symbol + 1, 0);
+		}
+		this->operatorIndex[symbol] = this->operators.size();
+		OperatorEntry entry = {op.priority, op.prefix, op.infix};
+		this->operators.push_back(entry);
+		//A right operand may then hold an operator of the same priority
+		if (op.associativity == RIGHT) {
+			this->operandPriorities[op.priority] = (PriorityEnum) (op.priority - 1);
+		}
+	}
 }
 
 void Parser :: declarationSpecifiers() {
 	//Storage class specifiers
-	this->mStorageClassSpecifier["typedef"] = "typedef";
-	this->mStorageClassSpecifier["extern"] = "extern";
-	this->mStorageClassSpecifier["static"] = "static";
-	this->mStorageClassSpecifier["_Thread_local"] = "_Thread_local";
-	this->mStorageClassSpecifier["auto"] = "auto";
-	this->mStorageClassSpecifier["register"] = "register";
+	this->mStorageClassSpecifier[Interner::intern("typedef")] = "typedef";
+	this->mStorageClassSpecifier[Interner::intern("extern")] = "extern";
+	this->mStorageClassSpecifier[Interner::intern("static")] = "static";
+	this->mStorageClassSpecifier[Interner::intern("_Thread_local")] = "_Thread_local";
+	this->mStorageClassSpecifier[Interner::intern("auto")] = "auto";
+	this->mStorageClassSpecifier[Interner::intern("register")] = "register";
 
 	//Type class specifiers
-	this->mTypeSpecifier["v"] = "v";
-	this->mTypeSpecifier["void"] = "void";
-	this->mTypeSpecifier["char"] = "char";
-	this->mTypeSpecifier["short"] = "short";
-	this->mTypeSpecifier["int"] = "int";
-	this->mTypeSpecifier["long"] = "long";
-	this->mTypeSpecifier["float"] = "float";
-	this->mTypeSpecifier["double"] = "double";
-	this->mTypeSpecifier["signed"] = "signed";
-	this->mTypeSpecifier["unsigned"] = "unsigned";
-	this->mTypeSpecifier["_Bool"] = "_Bool";
-	this->mTypeSpecifier["_Complex"] = "_Complex";
-	this->mTypeSpecifier["_Atomic"] = "_Atomic";
-	this->mTypeSpecifier["struct"] = "struct";
-	this->mTypeSpecifier["union"] = "union";
-	this->mTypeSpecifier["enum"] = "enum";
-	//Typedefs are missing here, since they are only a generic identifier
+	this->mTypeSpecifier[Interner::intern("void")] = "void";
+	this->mTypeSpecifier[Interner::intern("char")] = "char";
+	this->mTypeSpecifier[Interner::intern("short")] = "short";
+	this->mTypeSpecifier[Interner::intern("int")] = "int";
+	this->mTypeSpecifier[Interner::intern("long")] = "long";
+	this->mTypeSpecifier[Interner::intern("float")] = "float";
+	this->mTypeSpecifier[Interner::intern("double")] = "double";
+	this->mTypeSpecifier[Interner::intern("signed")] = "signed";
+	this->mTypeSpecifier[Interner::intern("unsigned")] = "unsigned";
+	this->mTypeSpecifier[Interner::intern("_Bool")] = "_Bool";
+	this->mTypeSpecifier[Interner::intern("_Complex")] = "_Complex";
+	this->mTypeSpecifier[Interner::intern("_Atomic")] = "_Atomic";
+	this->mTypeSpecifier[Interner::intern("struct")] = "struct";
+	this->mTypeSpecifier[Interner::intern("union")] = "union";
+	this->mTypeSpecifier[Interner::intern("enum")] = "enum";
+	//Typedef names are added as they are declared, see addTypedefNames()
 	
 	//Type qualifiers
-	this->mTypeQualifier["const"] = "const";
-	this->mTypeQualifier["restrict"] = "restrict";
-	this->mTypeQualifier["volatile"] = "volatile";
-	this->mTypeQualifier["_Atomic"] = "_Atomic";
+	this->mTypeQualifier[Interner::intern("const")] = "const";
+	this->mTypeQualifier[Interner::intern("restrict")] = "restrict";
+	this->mTypeQualifier[Interner::intern("volatile")] = "volatile";
+	this->mTypeQualifier[Interner::intern("_Atomic")] = "_Atomic";
 
 	//Function specifiers
-	this->mTypeSpecifier["inline"] = "inline";
-	this->mTypeSpecifier["_Noreturn"] = "_Noreturn";
+	this->mTypeSpecifier[Interner::intern("inline")] = "inline";
+	this->mTypeSpecifier[Interner::intern("_Noreturn")] = "_Noreturn";
 
 	//Alignment specifiers
-	this->mAlignmentSpecifier["_Alignas"] = "_Alignas";
+	this->mAlignmentSpecifier[Interner::intern("_Alignas")] = "_Alignas";
 }
 
 
@@ -1257,25 +1309,20 @@ bool ExternalDeclaration :: typeCheck(Scope* s) {
 Type* DeclarationSpecifierList :: getType(Scope* s) {
 	Type* ret = NULL;
 	string basicTypeName = "";
-	DeclarationSpecifier* curItem = item;
-	NodeList<DeclarationSpecifier>* curNext = next;
 	TypeSpecifier* curTypeSpec = NULL;
 	//Add all type specifiers to the string
-	while ((curTypeSpec = dynamic_cast<TypeSpecifier*>(curItem))) {
+	for (size_t k = 0; k < this->items.size() && \
+			(curTypeSpec = dynamic_cast<TypeSpecifier*>(this->items[k])); ++k) {
 		basicTypeName += curTypeSpec->getName();
-		if (curNext != NULL) {
-			curItem = curNext->getItem();
-			curNext = curNext->getNext();
+		if (k + 1 < this->items.size()) {
 			basicTypeName += " ";
-		} else {
-			break;
 		}
 	}
 	auto search = mBasicTypes.find(basicTypeName);
 	if (search != mBasicTypes.end()) {
-		ret = new BasicType(search->second);
+		ret = TypeContext::getBasicType(search->second);
 	} else if (basicTypeName == "void") {
-		ret = new NoType();
+		ret = TypeContext::getNoType();
 	}
 	return ret;
 }
@@ -1307,7 +1354,7 @@ map<string, BasicTypeEnum> DeclarationSpecifierList :: initBasicTypesMap() {
 bool Declarator ::  insert(Scope* s, Type* t) {
 	Pointer* ptrTmp = pointer;
 	while (ptrTmp != NULL) {
-		t = new PointerType(t);
+		t = TypeContext::getPointerType(t);
 		ptrTmp = ptrTmp->getNext();
 	}
 	return dirDecl->insert(s, t);
@@ -1317,10 +1364,10 @@ Type* Constant :: getType(string str) {
 	string::size_type search = str.find('.');
 	if (search != string::npos) {
 		//double
-		return new BasicType(DOUBLE);
+		return TypeContext::getBasicType(DOUBLE);
 	} else {
 		//int
-		return new BasicType(INT);
+		return TypeContext::getBasicType(INT);
 	}
 }
 
@@ -1,4 +1,5 @@
 //#include "source.h"
+#include <set>
 #include "abstractSyntax.h"
 
 template<class Op, const string* opStrTemp, PriorityEnum prioTemp>
@@ -15,7 +16,7 @@ class PrefixOperator : public Operator {
 		}
 		Type* getType(Scope* s) {
 			if (opStr == "&") {
-				return new PointerType(expr->getType(s));
+				return TypeContext::getPointerType(expr->getType(s));
 			} else if (opStr == "*") {
 				//Magic wand of dereference, downcast expr->getType() to a 
 				//PointerType and return pointeeType
@@ -101,7 +102,7 @@ class BinaryOperator : public InfixOperator {
 			if (lhsT == NULL || rhsT == NULL) {
 				return false;
 			}
-			if (*lhsT != *rhsT) {
+			if (lhsT != rhsT) {
 				string err = "Mismatched types '" + lhsT->getName() + "' and '" + \
 							  rhsT->getName() + "' in binary operator " + \
 							  this->getName();
@@ -250,18 +251,21 @@ class Parser {
 		DirectDeclarator* parseDirectDeclarator();
 		InitDeclarator* parseInitDeclarator();
 		InitDeclaratorList* parseInitDeclaratorList();
+		InitDeclaratorList* parseInitDeclaratorList(Declarator* first);
 		Initializer* parseInitializer();
 		Declaration* parseDeclaration();
 		DeclarationList* parseDeclarationList();
 		DeclarationSpecifierList* parseDeclarationSpecifierList();
-		DeclarationSpecifier* parseDeclarationSpecifier();
+		//A typedef name is only taken as a specifier if typedefName is set
+		DeclarationSpecifier* parseDeclarationSpecifier(bool typedefName = true);
 		StorageClassSpecifier* parseStorageClassSpecifier();
 		TypeSpecifier* parseTypeSpecifier();
 		TypeQualifier* parseTypeQualifier();
 		FunctionSpecifier* parseFunctionSpecifier();
 		AlignmentSpecifier* parseAlignmentSpecifier();
 		EnumeratorList* parseEnumeratorList();
-		FunctionDefinition* parseFunctionDefinition();
+		FunctionDefinition* parseFunctionDefinition(\
+				DeclarationSpecifierList* declSpecList, Declarator* decl);
 		ParameterTypeList* parseParameterTypeList();
 		ParameterList* parseParameterList();
 		ParameterDeclaration* parseParameterDeclaration();
@@ -271,25 +275,47 @@ class Parser {
 		DeclarationSpecifier* parseStructOrUnionSpecifier();
 		StructDeclarationList* parseStructDeclarationList();
 		StructDeclaration* parseStructDeclaration();
-		SpecifierQualifierList* parseSpecifierQualifierList();
+		SpecifierQualifierList* parseSpecifierQualifierList(bool typed = false);
 		StructDeclaratorList* parseStructDeclaratorList();
 		StructDeclarator* parseStructDeclarator();
 		ArgumentList* parseArgumentList();
-		map<string, string> mStorageClassSpecifier;
-		map<string, string> mTypeSpecifier;
-		map<string, string> mTypeQualifier;
-		map<string, string> mFunctionSpecifier;
-		map<string, string> mAlignmentSpecifier;
-		map<string, Operator* (*) (Parser*)> mPrefix; 
-		//Maps string to pointer to function which returns type Expression* and
-		//takes types Parser*, Expression* as input
-		map<string, InfixOperator* (*) (Parser*, Expression*)> mInfix; 
-		//Maps string to pointer to function which returns type Expression* and
-		//takes types Parser*, Expression* as input
-		void c11Operators(); //Inserts operators to parse C11 into the maps
+		//The maps are keyed by the interned name of a token, see Interner
+		map<unsigned int, string> mStorageClassSpecifier;
+		map<unsigned int, string> mTypeSpecifier;
+		map<unsigned int, string> mTypeQualifier;
+		map<unsigned int, string> mFunctionSpecifier;
+		map<unsigned int, string> mAlignmentSpecifier;
+		set<unsigned int> mTypedefName; //Declared by a typedef so far
+		typedef Operator* (*PrefixFactory) (Parser*);
+		typedef InfixOperator* (*InfixFactory) (Parser*, Expression*);
+		//How a token is parsed as an operator
+		struct OperatorEntry {
+			PriorityEnum priority; //As an infix operator, DEFAULT if not one
+			PrefixFactory prefix; //NULL if not a prefix operator
+			InfixFactory infix; //NULL if not an infix operator
+		};
+		//The operator with the interned name, an entry of neither if none
+		const OperatorEntry& findOperator(unsigned int symbol) const {
+			return operators[symbol < operatorIndex.size() ? \
+				operatorIndex[symbol] : 0];
+		}
+		//Parses the right operand of an infix operator of the priority
+		Expression* parseOperand(PriorityEnum priority) {
+			return parseExpression(operandPriorities[priority]);
+		}
+		void c11Operators(); //Enters the operators to parse C11
 		void declarationSpecifiers(); //Inserts C11 declaration specifiers
 	private:
+		bool isDeclarationSpecifier(unsigned int symbol) const;
+		void addTypedefNames(DeclarationSpecifierList* declSpecList, \
+				InitDeclaratorList* initDeclList);
+		void parseInitDeclarators(InitDeclaratorList* list);
 		BufferedSource<Token>* source;
+		vector<OperatorEntry> operators; //The first is of no operator
+		vector<unsigned char> operatorIndex; //Index of the entry of each symbol
+		//Priority to parse a right operand at, one lower for operators which
+		//are right-associative
+		PriorityEnum operandPriorities[PRIMARY + 1];
 };
 
 class Identifier : public Node {
@@ -305,7 +331,7 @@ class Identifier : public Node {
 				search = tempSearch->getType();
 			}
 			if (search == NULL) {
-				return new NoType();
+				return TypeContext::getNoType();
 			} 
 			return search;
 		}
@@ -316,14 +342,7 @@ class Identifier : public Node {
 class IdentifierList : public NodeList<Identifier> {
 	public:
 		IdentifierList(Identifier* item) : NodeList(item) {}
-		IdentifierList(Identifier* item, IdentifierList* next) \
-			: NodeList(item, next) {}
-		string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += ", " + next->getName();}
-			return ret;
-		}
+		string getName() {return this->join(", ");}
 };
 
 class Keyword : public Identifier {
@@ -454,8 +473,6 @@ class ExternalDeclaration : public Node {
 
 class TranslationUnit : public NodeList<ExternalDeclaration> {
 	public:
-		TranslationUnit(ExternalDeclaration* decl, TranslationUnit* next) : \
-			NodeList(decl, next) {}
 		TranslationUnit(ExternalDeclaration* decl) : NodeList(decl) {}
 };
 
@@ -482,21 +499,6 @@ class BlockItem : public Node {
 class BlockItemList : public NodeList<BlockItem> {
 	public:
 		BlockItemList(BlockItem* item) : NodeList(item) {}
-		BlockItemList(BlockItem* item, BlockItemList* next) : NodeList(item, next) {}
-		string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += "\n" + next->getName();}
-			return ret;
-		}
-		string genLLVM(Scope* s, Consumer<string>* o) {
-			if (item != NULL) {item->genLLVM(s, o);}
-			if (next != NULL) {
-				o->put("\n");
-				next->genLLVM(s, o);
-			}
-			return "";
-		}
 };
 
 class BlockItemListException : public SyntaxException {
@@ -519,7 +521,7 @@ class CompoundStatement : public Statement {
 			return ret;
 		}
 		virtual Type* getType(Scope* s) {
-			return new NoType();
+			return TypeContext::getNoType();
 		}
 		virtual bool typeCheck(Scope* s) {
 			Scope* localScope = new Scope(s);
@@ -678,7 +680,7 @@ class JumpStatement : public Statement {
 		}
 		Type* getType(Scope* s) {
 			if (expr != NULL) {return expr->getType(s);}
-			return new NoType();
+			return TypeContext::getNoType();
 		}
 		bool typeCheck(Scope* s) {
 			if (expr == NULL) {
@@ -686,7 +688,7 @@ class JumpStatement : public Statement {
 			}
 			if (keyword == "return") {
 				Type* search = s->find("return")->getType();
-				return *search == *expr->getType(s);
+				return search == expr->getType(s);
 			} else {
 				return true;
 			}
@@ -866,6 +868,7 @@ class Declarator : public Node {
 		string getName();
 		Pointer* getPointer() {return pointer;}
 		DirectDeclarator* getDirectDeclarator() {return dirDecl;}
+		Identifier* getIdentifier(); //NULL if the declarator is abstract
 		bool insert(Scope* s, Type* t);
 	private:
 		DirectDeclarator* dirDecl = NULL;
@@ -952,6 +955,7 @@ class DeclaratorDirectDeclarator : public DirectDeclarator {
 		virtual ~DeclaratorDirectDeclarator() {
 			if (decl != NULL) {delete decl;}
 		}
+		Declarator* getDeclarator() {return decl;}
 	private:
 		Declarator* decl = NULL;
 };
@@ -973,31 +977,19 @@ class ParameterDeclaration : public Node {
 
 class ParameterList : public NodeList<ParameterDeclaration> {
 	public:
-		ParameterList(ParameterDeclaration* item, ParameterList* list) \
-			: NodeList(item, list, ", ") {}
-		ParameterList(ParameterDeclaration* item) : NodeList(item) {}
-		string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += ", " + next->getName();}
-			return ret;
-		}
+		ParameterList(ParameterDeclaration* item) : NodeList(item, ", ") {}
+		string getName() {return this->join(", ");}
 		void getNames(Scope* s, list<string>* ret) {
-			NodeList<ParameterDeclaration>* tempList = this;
-			ParameterDeclaration* tempItem = item;
-			while (tempItem != NULL) {
-				Declarator* itemDecl = tempItem->getDeclarator();
+			for (ParameterDeclaration* item : this->items) {
+				if (item == NULL) {
+					break;
+				}
+				Declarator* itemDecl = item->getDeclarator();
 				if (itemDecl != NULL) {
 					ret->push_back(itemDecl->getName());
 				} else {
 					//TODO: Check that the type is void
 				}
-				tempList = tempList->getNext();
-				if (tempList != NULL) {
-					tempItem = tempList->getItem();
-				} else {
-						tempItem = NULL;
-					}
 			}
 		}
 		//Inserts each element into the scope s with the correct type
@@ -1005,15 +997,15 @@ class ParameterList : public NodeList<ParameterDeclaration> {
 		 * elements.
 		 */
 		static bool enterTypes(Scope* s, TypeList* typeList, list<string>* nameList) {
-			if (typeList == NULL && nameList->empty()) {
-				return true;
-			} else if (typeList == NULL || nameList->empty()) {
-				return false;
-			} else {
-				bool temp = s->insert(nameList->front(), typeList->getItem());
+			while (typeList != NULL && !nameList->empty()) {
+				bool entered = s->insert(nameList->front(), typeList->getItem());
 				nameList->pop_front();
-				return temp && enterTypes(s, typeList->getNext(), nameList);
+				if (!entered) {
+					return false;
+				}
+				typeList = typeList->getNext();
 			}
+			return typeList == NULL && nameList->empty();
 		}
 };
 
@@ -1130,14 +1122,7 @@ class InitDeclaratorException : public SyntaxException {
 class InitDeclaratorList : public NodeList<InitDeclarator> {
 	public:
 		InitDeclaratorList(InitDeclarator* item) : NodeList(item) {}
-		InitDeclaratorList(InitDeclarator* item, InitDeclaratorList* next) \
-			: NodeList(item, next) {}
-		string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += ", " + next->getName();}
-			return ret;
-		}
+		string getName() {return this->join(", ");}
 };
 
 class InitDeclaratorListException : public SyntaxException {
@@ -1159,15 +1144,16 @@ class DeclarationSpecifier : public Node {
 
 class DeclarationSpecifierList : public NodeList<DeclarationSpecifier> {
 	public:
-		DeclarationSpecifierList(DeclarationSpecifier* item, DeclarationSpecifierList* next) : NodeList(item, next) {
+		DeclarationSpecifierList(DeclarationSpecifier* item) : NodeList(item) {
 			if (mBasicTypes.empty()) {
 				initBasicTypesMap();
 			}
 		}
 		string getName() {
 			string ret = "";
-			if (item != NULL) {ret += item->getName() + " ";}
-			if (next != NULL) {ret += next->getName();}
+			for (DeclarationSpecifier* item : this->items) {
+				if (item != NULL) {ret += item->getName() + " ";}
+			}
 			return ret;
 		}
 		//TODO: Implement getType here, which will be the meat of insertion of 
@@ -1243,15 +1229,11 @@ class Declaration : public Node {
 					//Enter all declarations into the current scope
 					//First, get the type that they should have
 					Type* type = declList->getType(s);
-					InitDeclarator* initDecl = NULL;
-					NodeList<InitDeclarator>* initListTemp = initList;
-					while ((initDecl = initListTemp->getItem()) != NULL && \
-							initListTemp->getNext() != NULL)  {
-						initDecl-> insert(s, type);
-						initListTemp = initListTemp->getNext();
-					}
-					if ((initDecl = initListTemp->getItem()) != NULL) {
-						initDecl-> insert(s, type);
+					for (InitDeclarator* initDecl : initList->getItems()) {
+						if (initDecl == NULL) {
+							break;
+						}
+						initDecl->insert(s, type);
 					}
 					return true;
 				}
@@ -1269,8 +1251,6 @@ class DeclarationException : public SyntaxException {
 class DeclarationList : public NodeList<Declaration> {
 	public:
 		DeclarationList(Declaration* item) : NodeList(item) {}
-		DeclarationList(Declaration* item, DeclarationList* next) \
-			: NodeList(item, next) {}
 };
 
 class FunctionDefinition : public Node {
@@ -1312,13 +1292,14 @@ class FunctionDefinition : public Node {
 				if (paramList != NULL) {
 					paramTypes = paramList->getTypes(s);
 					paramList->getNames(s, paramNames);
-					typeOfThis = new FunctionType(declSpecList->getType(s), paramTypes);
+					typeOfThis = TypeContext::getFunctionType(declSpecList->getType(s), \
+							paramTypes);
 					ParameterList::enterTypes(s, paramTypes, \
 							paramNames);
 				}
 			} else {
-				typeOfThis = new FunctionType(declSpecList->getType(s), \
-						new TypeList(new NoType()));
+				typeOfThis = TypeContext::getFunctionType(declSpecList->getType(s), \
+						TypeContext::getTypeList(TypeContext::getNoType()));
 			}
 			return typeOfThis;
 		}
@@ -1357,12 +1338,13 @@ class FunctionDefinition : public Node {
 			if (paramList != NULL) {
 				paramTypes = paramList->getTypes(functionScope);
 				paramList->getNames(functionScope, paramNames);
-				typeOfThis = new FunctionType(declSpecList->getType(s), paramTypes);
+				typeOfThis = TypeContext::getFunctionType(declSpecList->getType(s), \
+						paramTypes);
 				ParameterList::enterTypes(functionScope, paramTypes, \
 						paramNames);
 			} else {
-				typeOfThis = new FunctionType(declSpecList->getType(s), \
-						new TypeList(new NoType()));
+				typeOfThis = TypeContext::getFunctionType(declSpecList->getType(s), \
+						TypeContext::getTypeList(TypeContext::getNoType()));
 			}
 			//Else, no parameters, which is OK
 			//And enter the special case 'return' as well
@@ -1482,14 +1464,7 @@ class Enumerator : public Expression {
 class EnumeratorList : public NodeList<Enumerator> {
 	public:
 		EnumeratorList(Enumerator* item) : NodeList(item) {}
-		EnumeratorList(Enumerator* item, EnumeratorList* next) : \
-			NodeList(item, next) {}
-		string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += ", " + next->getName();}
-			return ret;
-		}
+		string getName() {return this->join(", ");}
 };
 
 
@@ -1534,14 +1509,10 @@ class TypeQualifier : public DeclarationSpecifier {
 
 class TypeQualifierList : public NodeList<TypeQualifier> {
 	public:
-		TypeQualifierList(TypeQualifier* item, TypeQualifierList* next) : \
-			NodeList(item, next) {}
 		TypeQualifierList(TypeQualifier* item) : NodeList(item) {}
 		string getName() {
-			string ret = "";
-			if (item != NULL) {ret = item->getName();}
-			if (next != NULL) {ret = next->getName();}
-			return ret;
+			TypeQualifier* last = this->items.back();
+			return last != NULL ? last->getName() : "";
 		}
 };
 
@@ -1558,7 +1529,7 @@ class AlignmentSpecifier : public DeclarationSpecifier {
 			Token token = parser->getSource()->get();
 			if (token.getName() == "(") {
 				token = parser->getSource()->peek();
-				auto search = parser->mTypeSpecifier.find(token.getName());
+				auto search = parser->mTypeSpecifier.find(token.getSymbol());
 				if (search != parser->mTypeSpecifier.end()) {
 					parser->getSource()->get();
 					type = token;
@@ -1610,14 +1581,7 @@ class StructDeclarator : public Node {
 class StructDeclaratorList : public NodeList<StructDeclarator> {
 	public:
 		StructDeclaratorList(StructDeclarator* item) : NodeList(item) {}
-		StructDeclaratorList(StructDeclarator* item, StructDeclaratorList* next)\
-			: NodeList(item, next) {}
-		virtual string getName() {
-			string ret = "";
-			if (item != NULL) {ret += item->getName();}
-			if (next != NULL) {ret += next->getName();}
-			return ret;
-		}
+		virtual string getName() {return this->join("");}
 };
 
 class SpecifierQualifierList : public Node {
@@ -1665,7 +1629,6 @@ class StructDeclaration : public Node {
 class StructDeclarationList : public NodeList<StructDeclaration> {
 	public:
 		StructDeclarationList(StructDeclaration* item) : NodeList(item) {}
-		StructDeclarationList(StructDeclaration* item, StructDeclarationList* next) : NodeList(item, next) {}
 };
 
 class StructSpecifier : public DeclarationSpecifier {
@@ -1931,7 +1894,7 @@ class Equality : public BinaryOperator<Expression, &EqualityOpStr, EQUALITY> {
 			return "icmp eq";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -1955,7 +1918,7 @@ class NonEquality : public BinaryOperator<Expression, &NonEqualityOpStr, EQUALIT
 			return "icmp ne";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -1984,7 +1947,7 @@ class LessThan : public BinaryOperator<Expression, &LessThanOpStr, RELATIONAL> {
 			return "icmp slt";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -2013,7 +1976,7 @@ class GreaterThan : public BinaryOperator<Expression, &GreaterThanOpStr, RELATIO
 			return "icmp sgt";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -2042,7 +2005,7 @@ class LessThanOrEqual : public BinaryOperator<Expression, &LessThanOrEqualOpStr,
 			return "icmp sle";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -2071,7 +2034,7 @@ class GreaterThanOrEqual : public BinaryOperator<Expression, &GreaterThanOrEqual
 			return "icmp sge";
 		}
 		Type* getType(Scope* s) {
-			return new BasicType(_BOOL);
+			return TypeContext::getBasicType(_BOOL);
 		}
 };
 
@@ -2505,29 +2468,32 @@ class ArraySubscript : public BinaryOperator<Expression, &ArraySubscriptOpStr, P
 
 class ArgumentList : public Expression {
 	public:
-		ArgumentList(Expression* assignExpr, ArgumentList* next) : \
-			Expression(DEFAULT), expr(assignExpr), next(next) {}
+		ArgumentList(Expression* assignExpr) : Expression(DEFAULT), \
+			exprs(1, assignExpr) {}
 		void parse(Parser* parser) {
 		}
+		void add(Expression* assignExpr) {exprs.push_back(assignExpr);}
 		string getName() {
 			string ret = "";
-			if (expr != NULL) {ret += expr->getName();}
-			if (next != NULL) {ret += next->getName();}
+			for (Expression* expr : exprs) {
+				if (expr != NULL) {ret += expr->getName();}
+			}
 			return ret;
 		}
 		string genLLVM(Scope* s, Consumer<string>* o) {
 			string ret = "";
-			if (expr != NULL) {
-				ret += expr->getType(s)->getLLVMName() + " " + expr->genLLVM(s, o);
-			}
-			if (next != NULL) {
-				ret += ", " + next->genLLVM(s, o);
+			for (size_t k = 0; k < exprs.size(); ++k) {
+				if (k > 0) {ret += ", ";}
+				Expression* expr = exprs[k];
+				if (expr != NULL) {
+					ret += expr->getType(s)->getLLVMName() + " " + \
+						   expr->genLLVM(s, o);
+				}
 			}
 			return ret;
 		}
 	private:
-		Expression* expr = NULL;
-		ArgumentList* next = NULL;
+		vector<Expression*, ArenaAllocator<Expression*> > exprs;
 };
 
 const string FunctionCallOpStr = "(";
@@ -2610,7 +2576,6 @@ class GenericAssociation : public Expression {
 class GenericAssociationList : public NodeList<GenericAssociation> {
 	public:
 		GenericAssociationList(GenericAssociation* assoc) : NodeList(assoc) {}
-		GenericAssociationList(GenericAssociation* assoc, GenericAssociationList* list) : NodeList(assoc, list) {}
 };
 
 const string GenericOpStr = "_Generic";
@@ -2636,16 +2601,12 @@ class Generic : public PrefixOperator<Expression, &GenericOpStr, UNARY> {
 					first->parse(parser);
 					list = new GenericAssociationList(first);
 				}
-				GenericAssociationList* currentList = list;
-				GenericAssociationList* nextList = NULL;
 				GenericAssociation* assoc = NULL;
 				token = parser->getSource()->get();
 				while (token.getName() == ",") {
 					assoc = new GenericAssociation(token);
 					assoc->parse(parser);
-					nextList = new GenericAssociationList(assoc);
-					currentList->setNext(nextList);
-					currentList = nextList;
+					list->add(assoc);
 					token = parser->getSource()->get();
 				}
 				if (token.getName() != ")") {
@@ -2691,7 +2652,7 @@ void PostfixOperator<Op, opStrTemp, prioTemp> :: parse(Parser* parser) {
 
 template<class Op, const string* opStrTemp, PriorityEnum prioTemp>
 void BinaryOperator<Op, opStrTemp, prioTemp> :: parse(Parser* parser) {
-	rhs = parser->parseExpression(prioTemp);
+	rhs = parser->parseOperand(prioTemp);
 }
 
 template<class Op, const string* opStrTemp, PriorityEnum prioTemp>
@@ -2730,7 +2691,7 @@ void TernaryOperator<Left, Middle, Right, opStrFirst, opStrSecond, prioTemp> ::
 	mhs = parser->parseExpression(prioTemp);
 	Token secondOp = parser->getSource()->get();
 	if (secondOp.getName() == *opStrSecond) {
-		rhs = parser->parseExpression(prioTemp);
+		rhs = parser->parseOperand(prioTemp);
 	} else {
 		string err = "Expected '" + *opStrSecond + "' as second operator in ternary"\
 					  " operator";
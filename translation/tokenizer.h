@@ -2,6 +2,7 @@
 #include <fstream>
 #include <string>
 #include <map>
+#include "interner.h"
 using namespace std;
 
 int main(int argc, char *argv[]);
@@ -14,8 +15,8 @@ class Position {
 	public:
 		Position() : line(0), column(0) {}
 		Position(unsigned int l, unsigned int c) : line(l), column(c) {}
-		unsigned int getLine() {return line;}
-		unsigned int getColumn() {return column;}
+		unsigned int getLine() const {return line;}
+		unsigned int getColumn() const {return column;}
 		void setLine(unsigned int input) {line = input;}
 		void setColumn(unsigned int input) {column = input;}
 	private:
@@ -27,42 +28,55 @@ enum TokenKey { OTHER,  HEADERNAME, IDENTIFIER, PPNUMBER, CHARACTERCONSTANT, \
    STRINGLITERAL, PUNCTUATOR, WHITESPACE, KEYWORD, CONSTANT}; 
 
 //! A token, i.e. a character or a word or some such
+/*! The name is interned, see Interner, so a token is small and can be copied
+ * without allocating. Two tokens have the same name exactly when they have the
+ * same symbol.
+ */
 class Token {
 	public:
 		Token(unsigned int line = 0, unsigned int column = 0, \
-				string name = "", TokenKey id = IDENTIFIER) : \
+				const string& name = "", TokenKey id = IDENTIFIER) : \
 			Token(Position(line, column), name, id) {}
-		Token(Position pos, string name = "", TokenKey id = IDENTIFIER)\
-										   : position(pos), name(name), id(id) {}
-		unsigned int getLine() {return position.getLine();}
-		unsigned int getColumn() {return position.getColumn();}
-		Position getPosition() {return position;}
-		const string getName() {return name;}
-		TokenKey getKey() {return id;};
+		Token(Position pos, const string& name = "", TokenKey id = IDENTIFIER)\
+			: Token(pos, Interner::intern(name), id) {}
+		Token(Position pos, unsigned int symbol, TokenKey id) : position(pos), \
+																symbol(symbol), \
+																id(id) {}
+		unsigned int getLine() const {return position.getLine();}
+		unsigned int getColumn() const {return position.getColumn();}
+		Position getPosition() const {return position;}
+		const string& getName() const {return Interner::lookup(symbol);}
+		unsigned int getSymbol() const {return symbol;}
+		TokenKey getKey() const {return id;};
 	private:
 		Position position;
-		string name;
+		unsigned int symbol; //The interned name
 		TokenKey id;
 };
+static_assert(sizeof(Token) <= 16, "Tokens are meant to be cheap to copy");
 
 //! A preprocessing token used in phases 3 to 7
 class PPToken : public Token {
 	public:
 		PPToken(unsigned int line = 0, unsigned int column = 0, \
-				string name = "", TokenKey id = IDENTIFIER) : \
+				const string& name = "", TokenKey id = IDENTIFIER) : \
 			Token(line, column, name, id) {}
-		PPToken(Position pos, string name = "", TokenKey id = IDENTIFIER) : \
+		PPToken(Position pos, const string& name = "", TokenKey id = IDENTIFIER) : \
 			Token(pos, name,id) {}
+		PPToken(Position pos, unsigned int symbol, TokenKey id) : \
+			Token(pos, symbol, id) {}
 };
 
 class PPTokenInternal : public PPToken {
 	public:
 		PPTokenInternal(unsigned int line = 0, unsigned int column = 0, \
-				string name = "", TokenKey id = IDENTIFIER, \
+				const string& name = "", TokenKey id = IDENTIFIER, \
 				unsigned int used = 1) : \
 			PPToken(line, column, name, id), used(used) {}
-		PPTokenInternal(Position pos, string name = "", TokenKey id = IDENTIFIER,\
+		PPTokenInternal(Position pos, const string& name = "", TokenKey id = IDENTIFIER,\
 				unsigned int used = 1)  : PPToken(pos, name,id), used(used) {}
+		PPTokenInternal(Position pos, unsigned int symbol, TokenKey id, \
+				unsigned int used) : PPToken(pos, symbol, id), used(used) {}
 		unsigned int getUsed() {return used;}
 	private:
 		unsigned int used; //How many tokens of the input were used to create this
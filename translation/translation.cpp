@@ -1,18 +1,158 @@
 #include "translation.h"
 #include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cstdlib>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 int main(int argc, char *argv[]) {
 	string filename;
-	if (argc > 1) {
-		filename = argv[1];
-	} else {
+	string outputname; //Standard output if empty
+	bool stats = false;
+	bool preprocessOnly = false;
+	bool emitPrecompiled = false;
+	string precompiledname; //Header given by --include-pch
+	bool scanDependencies = false;
+	bool json = false; //Dependencies as JSON instead of Make rules
+	unsigned int jobs = 1;
+	unsigned int prefetchThreads = IncludePrefetcher::defaultThreads;
+	vector<string> filenames;
+	string options; //The arguments given, which are not file names
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		//Include directories, given as "-I dir" or "-Idir"
+		string dirOptions[] = {"-iquote", "-isystem", "-I"};
+		string option = "";
+		for (const string& candidate : dirOptions) {
+			if (arg.compare(0, candidate.length(), candidate) == 0) {
+				option = candidate;
+				break;
+			}
+		}
+		if (option.length() > 0) {
+			string dir = arg.substr(option.length());
+			if (dir.length() == 0) {
+				if (i + 1 >= argc) {
+					cout << "Error: Expected a directory after " << option << '\n';
+					return 1;
+				}
+				dir = argv[++i];
+			}
+			if (option == "-iquote") {
+				IncludeResolver::addQuoteDirectory(dir);
+			} else if (option == "-isystem") {
+				IncludeResolver::addSystemDirectory(dir);
+			} else {
+				IncludeResolver::addDirectory(dir);
+			}
+		} else if (arg == "--stats") {
+			stats = true;
+		} else if (arg == "-E") {
+			preprocessOnly = true;
+		} else if (arg == "--scan-deps" || arg == "--scan-deps=make" || \
+				arg == "--scan-deps=json") {
+			scanDependencies = true;
+			json = arg == "--scan-deps=json";
+		} else if (arg.compare(0, 2, "-j") == 0) {
+			string count = arg.substr(2);
+			if (count.length() == 0 && i + 1 < argc) {
+				count = argv[++i];
+			}
+			int parsed = atoi(count.c_str());
+			if (parsed < 1) {
+				cout << "Error: Expected a number of jobs after -j" << '\n';
+				return 1;
+			}
+			jobs = parsed;
+		} else if (arg == "--prefetch-threads") {
+			int parsed = i + 1 < argc ? atoi(argv[++i]) : -1;
+			if (parsed < 0) {
+				cout << "Error: Expected a number of threads after " << arg << '\n';
+				return 1;
+			}
+			prefetchThreads = parsed;
+			continue;
+		} else if (arg == "--cache-dir" || arg == "--cache-size") {
+			if (i + 1 >= argc) {
+				cout << "Error: Expected a value after " << arg << '\n';
+				return 1;
+			}
+			string value = argv[++i];
+			if (arg == "--cache-dir") {
+				ResultCache::setDirectory(value);
+				continue;
+			}
+			//Bytes, or with a suffix K, M or G
+			char* suffix;
+			uint64_t bytes = strtoull(value.c_str(), &suffix, 10);
+			string units = "KMG";
+			string::size_type unit = units.find(toupper(*suffix));
+			if (*suffix != '\0' && unit != string::npos) {
+				bytes <<= 10 * (unit + 1);
+			}
+			ResultCache::setLimit(bytes);
+		} else if (arg == "--emit-pch") {
+			emitPrecompiled = true;
+		} else if (arg == "--include-pch") {
+			if (i + 1 >= argc) {
+				cout << "Error: Expected a file name after --include-pch" << '\n';
+				return 1;
+			}
+			precompiledname = argv[++i];
+		} else if (arg == "-o") {
+			if (i + 1 >= argc) {
+				cout << "Error: Expected a file name after -o" << '\n';
+				return 1;
+			}
+			outputname = argv[++i];
+		} else {
+			filename = arg;
+			filenames.push_back(arg);
+			continue;
+		}
+		//Everything but the files is part of the key of a cached result
+		if (arg != "--stats" && arg.compare(0, 8, "--cache-") != 0) {
+			options += arg + '\0';
+		}
+	}
+	ResultCache::setOptions(options);
+	if (filename.length() == 0) {
 		filename = "~/toycc/test/include.c"; //Tokenizing
 		filename = "~/toycc/test/expressions.c"; //Parsing
 		filename = "~/toycc/test/externaldeclarations.c"; //More parsing
 		filename = "~/toycc/test/ir.c"; //Code generation
 	}
 	try {
-	return translate(filename);
+	if (precompiledname.length() > 0) {
+		PrecompiledHeader::include(precompiledname);
+	}
+	//Scanning has threads of its own, which lex each header once anyway
+	if (prefetchThreads > 0 && !scanDependencies) {
+		IncludePrefetcher::start(prefetchThreads);
+		IncludePrefetcher::prefetch(filename);
+	}
+	int ret;
+	try {
+		if (scanDependencies) {
+			ret = scanDeps(filenames, json, jobs, outputname);
+		} else if (emitPrecompiled) {
+			ret = precompile(filename, outputname);
+		} else if (preprocessOnly) {
+			ret = preprocess(filename, outputname);
+		} else {
+			ret = translate(filename);
+		}
+	} catch (...) {
+		IncludePrefetcher::stop();
+		throw;
+	}
+	IncludePrefetcher::stop();
+	if (stats) {
+		printStats();
+	}
+	return ret;
 	} catch (IOException& error) {
 		cout << "Error relating to input/output: " << error.what() << "\n";
 		return 2;
@@ -28,43 +168,117 @@ int main(int argc, char *argv[]) {
 	}
 }
 
+//! Prints counters of the preprocessor to standard error
+void printStats() {
+	cerr << "Include lookups: " << IncludeResolver::getLookups() << '\n';
+	cerr << "Include lookups cached: " << IncludeResolver::getCacheHits() \
+		<< '\n';
+	cerr << "Include probes: " << IncludeResolver::getProbes() << '\n';
+	cerr << "Include probes without system call: " << \
+		IncludeResolver::getStatsSaved() << '\n';
+	cerr << "Directories read: " << IncludeResolver::getDirectoryReads() \
+		<< '\n';
+	cerr << "Token cache hits: " << TokenCache::getHits() << '\n';
+	cerr << "Token cache misses: " << TokenCache::getMisses() << '\n';
+	cerr << "Headers prefetched: " << IncludePrefetcher::getPrefetched() << '\n';
+	cerr << "Bytes skipped in inactive groups: " << \
+		Preprocessor::getSkippedBytes() << '\n';
+	cerr << "Includes skipped: " << Preprocessor::getSkippedIncludes() << '\n';
+	cerr << "Result cache hits: " << ResultCache::getHits() << '\n';
+	cerr << "Result cache misses: " << ResultCache::getMisses() << '\n';
+	cerr << "Result cache evictions: " << ResultCache::getEvictions() << '\n';
+	cerr << "AST arena bytes: " << NodeArena::getBytes() << '\n';
+	cerr << "AST arena chunks: " << NodeArena::getChunks() << '\n';
+	cerr << "Types made: " << TypeContext::getMade() << '\n';
+	cerr << "Type lookups: " << TypeContext::getLookups() << '\n';
+}
+
+//! Writes the preprocessed tokens of the file to outputname, for -E
+int preprocess(string filename, string outputname) {
+	Preprocessor* preprocessor = new Preprocessor(filename);
+	int fd = STDOUT_FILENO;
+	if (outputname.length() > 0) {
+		fd = open(outputname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			throw IOException("Could not open " + outputname + " for writing");
+		}
+	}
+	PreprocessedWriter writer(*preprocessor, fd);
+	while (!preprocessor->empty()) {
+		writer.put(preprocessor->get());
+	}
+	writer.finish();
+	if (fd != STDOUT_FILENO) {
+		close(fd);
+	}
+	delete preprocessor;
+	return 0;
+}
+
+//! Writes the files each file includes, for --scan-deps
+int scanDeps(const vector<string>& filenames, bool json, unsigned int jobs, \
+		string outputname) {
+	int fd = STDOUT_FILENO;
+	if (outputname.length() > 0) {
+		fd = open(outputname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			throw IOException("Could not open " + outputname + " for writing");
+		}
+	}
+	int ret = DependencyScanner::run(filenames, json, jobs, fd);
+	if (fd != STDOUT_FILENO) {
+		close(fd);
+	}
+	return ret;
+}
+
+//! Writes the header filename as a precompiled header, for --emit-pch
+int precompile(string filename, string outputname) {
+	if (outputname.length() == 0) {
+		outputname = filename + ".pch";
+	}
+	//Not streamed, the include guard of the header goes in the output
+	Preprocessor* preprocessor = new Preprocessor(filename, false);
+	preprocessor->precompile(outputname);
+	delete preprocessor;
+	return 0;
+}
+
 int translate(string filename) {
-	Type* testInt = new BasicType(INT);
-	Type* testDouble = new BasicType(DOUBLE);
-	TypeList* testTypeListLast = new TypeList(testDouble);
-	TypeList* testTypeListFirst = new TypeList(testInt, testTypeListLast);
-	Type* testType = new StructType(testTypeListFirst);
+	Type* testInt = TypeContext::getBasicType(INT);
+	Type* testDouble = TypeContext::getBasicType(DOUBLE);
+	TypeList* testTypeListLast = TypeContext::getTypeList(testDouble);
+	TypeList* testTypeListFirst = TypeContext::getTypeList(testInt, \
+			testTypeListLast);
+	Type* testType = TypeContext::getStructType(testTypeListFirst);
 	//cout << "Size of struct: " << testType->getSize() << '\n';
 	
-	ifstream filestream = ifstream(filename);
-	stringstream stream1to2 = stringstream(std::ios_base::in
-                              | std::ios_base::out
-                              | std::ios_base::app);
-	stringstream stream2to3 = stringstream(std::ios_base::in
-                              | std::ios_base::out
-                              | std::ios_base::app);
-	phase1(&filestream, &stream1to2);
-	phase2(&stream1to2 , &stream2to3);
-
-	/*After the first two, very simple, phases, introduce some 
-	 * object-orientation. First, turn stream2to3 into a Source<char>
-	 * via StreamSource<char>
-	 */
-	StreamSource<char>* lexSource = new StreamSource<char>(&stream2to3);
-	BufferedSource<char>* bufLexSource = new BufferedSource<char>(lexSource);
-	Lexer* lexer = new Lexer(bufLexSource); 
-	lexer->empty();
+	//The preprocessor maps the file and performs phases 1 through 4
 	Preprocessor* preprocessor = new Preprocessor(filename);
 	BufferedSource<PPToken>* bufPPPSource = new BufferedSource<PPToken>\
 											(preprocessor);
 	PostPPTokenizer* pppTokenizer = new PostPPTokenizer(*bufPPPSource);
-	WhiteSpaceCleaner* whitespacecleaner = new WhiteSpaceCleaner(*pppTokenizer);
-	BufferedSource<Token>* bufStrLitConCatSource = new BufferedSource<Token>\
-												   (whitespacecleaner);
-	StrLitConCat* strlitconcat = new StrLitConCat(*bufStrLitConCatSource);
-	BufferedSource<Token>* bufParserSource = new BufferedSource<Token>\
-											 (strlitconcat);
+	string ofilename = filename.substr(0, filename.length() - 1) + "ll"; //Assume
+	//*.c -> *.ll
+	BufferedSource<Token>* bufParserSource;
+	string key; //Of the result in the cache, if it is used
+	if (ResultCache::isEnabled()) {
+		//All tokens are needed for the key before anything is parsed
+		vector<Token>* tokens = new vector<Token>();
+		while (!pppTokenizer->empty()) {
+			tokens->push_back(pppTokenizer->get());
+		}
+		key = ResultCache::key(*tokens);
+		if (ResultCache::fetch(key, ofilename)) {
+			return 0;
+		}
+		bufParserSource = new BufferedSource<Token>(new VectorSource<Token>\
+				(tokens, pppTokenizer));
+	} else {
+		bufParserSource = new BufferedSource<Token>(pppTokenizer);
+	}
 	Parser* parser = new Parser(bufParserSource);
+	bool written = false; //True once ofilename has been written
 	Expression* ptr = NULL;
 	while (true) {
 		ptr = NULL;
@@ -79,19 +293,24 @@ int translate(string filename) {
 			Scope* scope = new Scope();
 			//cout << "Type check: " << ptr->typeCheck(scope) << '\n';
 			//cout << ptr->getName() << '\n';
-			filename.pop_back(); //Remove final char from string (c in *.c)
-			string ofilename = filename + "ll"; //Assume *.c -> *.ll
 			ofstream filestream = ofstream(ofilename);
 			Consumer<string>* llvmOutput = new StreamConsumer(filestream);
 			llvmOutput->put("target triple = \"x86_64-apple-macosx10.9.0\"\n");
 			ptr->genLLVM(scope, llvmOutput);
 			//cout << ptr->getType(scope)->getName() << '\n';
+			written = true;
 		}
 	}
+	if (written && key.length() > 0) {
+		ResultCache::store(key, ofilename);
+	}
+	//The tree is dropped as a whole, none of its destructors are needed
+	TypeContext::release();
+	NodeArena::release();
 		
 	//Tokenization printing code
 	/*while (true) {
-		Token token = strlitconcat->get();
+		Token token = pppTokenizer->get();
 		string current = token.getName();
 		TokenKey key = token.getKey();
 		if (current.length() > 0)
@@ -99,7 +318,7 @@ int translate(string filename) {
 			cout << current << ": " << key << '\n';
 			//cout << current;
 		}
-		if (strlitconcat->empty())
+		if (pppTokenizer->empty())
 		{
 			break;
 		}
@@ -107,31 +326,14 @@ int translate(string filename) {
 	return 0;
 }
 
-int phase1(istream *input, ostream *output) {
-	bool eof = false;
-	while(!eof) {
-		char read = input->get();
-		if (input->eof()) {
-			eof = true;
-			break;
-		}
-		//Check for trigraph sequence
-		input->unget();
-		read = trigraph(input);
-		*output << read;
-	}
-	return 0;
-}
-
-char trigraph(istream *input) {
-	char read = input->get();
+char LineSplicer :: trigraph(size_t& at) {
+	char read = this->data[at++];
 	/* If possible trigraph, check if third graph also matches and
 	 * if so, return the converted character, otherwise return first
 	 * character.
 	 */
-	if (read == '?' && input->peek() == '?') {
-		input->get();
-		switch (input->get()) {
+	if (read == '?' && at + 1 < this->length && this->data[at] == '?') {
+		switch (this->data[at + 1]) {
 			case '=': 
 				read = '#';
 				break;
@@ -160,210 +362,404 @@ char trigraph(istream *input) {
 				read = '~';
 				break;
 			default:
-				input->unget();
-				input->unget();
-				break;
+				return read;
 		}
+		at += 2;
 	}
 	return read;
 }
 
-int phase2(istream *input, ostream *output) {
-	bool eof = false;
-	while(!eof) {
-		char read = input->get();
-		if (input->eof()) {
-			eof = true;
-			break;
+size_t LineSplicer :: scan(size_t from) {
+	const char* current = this->data + from;
+	const char* end = this->data + this->length;
+#if defined(__AVX2__)
+	const __m256i question32 = _mm256_set1_epi8('?');
+	const __m256i backslash32 = _mm256_set1_epi8('\\');
+	while (end - current >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*) current);
+		unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(\
+					_mm256_cmpeq_epi8(block, question32), \
+					_mm256_cmpeq_epi8(block, backslash32)));
+		if (mask != 0) {
+			return (current - this->data) + __builtin_ctz(mask);
 		}
-		while (read == '\\' && input->peek() == '\n') {
-			input->get();
-			read = input->get();
+		current += 32;
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i question = _mm_set1_epi8('?');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	while (end - current >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*) current);
+		unsigned int mask = _mm_movemask_epi8(_mm_or_si128(\
+					_mm_cmpeq_epi8(block, question), \
+					_mm_cmpeq_epi8(block, backslash)));
+		if (mask != 0) {
+			return (current - this->data) + __builtin_ctz(mask);
 		}
-		output->put(read);
+		current += 16;
 	}
-	return 0;
+#endif
+	//Tail of the file, or no vector instructions available
+	while (current < end && *current != '?' && *current != '\\') {
+		++current;
+	}
+	return current - this->data;
 }
 
-PPToken Lexer :: get() {
-	TokenKey key = OTHER;
-	string str = "";
-	string testStr = "";
-	//Waste comments
-	PPToken testToken = this->matchComment();
-	testStr = testToken.getName();
-	if (testStr.length() > 0) {
-		key = WHITESPACE;
-		PPToken ppt= PPToken(0, 0, " ", key);
-		return ppt;
+char LineSplicer :: get() {
+	//Fast path, inside a run without trigraphs or line splices
+	if (this->pos < this->cleanEnd) {
+		return this->data[this->pos++];
+	}
+	if (this->pos >= this->length) {
+		this->exhausted = true;
+		return '\0';
+	}
+	char first = this->data[this->pos];
+	if (first != '?' && first != '\\') {
+		this->cleanEnd = this->scan(this->pos);
+		return this->data[this->pos++];
+	}
+	size_t start = this->pos;
+	char read = this->trigraph(this->pos);
+	//Splice lines, i.e. remove each backslash directly followed by new-line
+	while (read == '\\' && this->pos < this->length) {
+		size_t ahead = this->pos;
+		if (this->trigraph(ahead) != '\n') {
+			break;
+		}
+		this->splices.push_back(start - this->removed);
+		this->pos = ahead;
+		if (this->pos >= this->length) {
+			this->exhausted = true;
+			return '\0';
+		}
+		read = this->trigraph(this->pos);
 	}
-	this->bufSource->reset();
+	this->removed += this->pos - start - 1;
+	return read;
+}
 
-	//Match identifier
-	testToken = this->matchIdentifier();
-	testStr = testToken.getName();
-	if (testStr.length() > str.length()) {
-		key = IDENTIFIER;
-		str = testStr;
-	}
-	this->bufSource->reset();
-	
-	//Match PPNumber
-	testToken = this->matchPPNumber();
-	testStr = testToken.getName();
-	if (testStr.length() > str.length()) {
-		key = PPNUMBER;
-		str = testStr;
+size_t LineSplicer :: getBatch(char* out, size_t max) {
+	size_t count = 0;
+	while (count < max && !this->exhausted) {
+		if (this->pos < this->cleanEnd) {
+			//Copy as much of the clean run as fits
+			size_t run = this->cleanEnd - this->pos;
+			if (run > max - count) {
+				run = max - count;
+			}
+			memcpy(out + count, this->data + this->pos, run);
+			this->pos += run;
+			count += run;
+		} else {
+			//Finds the next clean run, or handles a trigraph or splice
+			out[count++] = this->LineSplicer::get();
+		}
 	}
-	this->bufSource->reset();
+	return count;
+}
 
+//Character classes of the lexer's DFA
+enum CharClass {C_OTHER, C_SPACE, C_NEWLINE, C_LETTER, C_EXPONENT, C_DIGIT, \
+	C_DOT, C_SIGN, C_SLASH, C_STAR, C_NUL, CHAR_CLASSES};
 
-	//Match other
-	if (str.length() == 0)
-	{
-		char c = bufSource->get();
-		str += c;
-		if (iswspace(c)) {
-			key = WHITESPACE;
-		} else {
-			key = OTHER;
+//States of the lexer's DFA, LEX_DONE means the lexeme ended before the
+//character that was looked at
+enum LexState {LEX_START, LEX_SPACE, LEX_OTHER, LEX_IDENTIFIER, LEX_NUMBER, \
+	LEX_NUMBER_EXPONENT, LEX_SLASH, LEX_LINE_COMMENT, LEX_BLOCK_COMMENT, \
+	LEX_BLOCK_STAR, LEX_BLOCK_END, LEX_STATES, LEX_DONE = LEX_STATES};
+
+static unsigned char charClasses[256];
+
+static bool initCharClasses() {
+	for (unsigned int c = 0; c < 256; ++c) {
+		charClasses[c] = C_OTHER;
+		if (isalpha(c) || c == '_') {
+			charClasses[c] = C_LETTER;
+		} else if (isdigit(c)) {
+			charClasses[c] = C_DIGIT;
+		} else if (isspace(c)) {
+			charClasses[c] = C_SPACE;
 		}
-		bufSource->get();
 	}
-	bufSource->reset();
-	PPToken pptoken = PPToken(this->getPosition(), str, key);
-	return pptoken;
-
+	charClasses['e'] = charClasses['E'] = C_EXPONENT;
+	charClasses['p'] = charClasses['P'] = C_EXPONENT;
+	charClasses['\n'] = C_NEWLINE;
+	charClasses['.'] = C_DOT;
+	charClasses['+'] = charClasses['-'] = C_SIGN;
+	charClasses['/'] = C_SLASH;
+	charClasses['*'] = C_STAR;
+	charClasses['\0'] = C_NUL;
+	return true;
 }
 
+static bool charClassesReady = initCharClasses();
 
-PPToken Lexer :: matchPPNumber() {
-	string str = "";
-	char current = source.get();
-	if (isdigit(current)) { //should maybe (include || current == '.'), but that is
-		//currently removed to make sure that struct access, a.b, works
-		str += current;
-		current = source.get();
-		while (isalnum(current) || current == '.') {
-			str += current;
-			if (current == 'e' || current == 'E' || current == 'p' || \
-					current == 'P') {
-				char expectedSign = source.get();
-				if (expectedSign == '+' || expectedSign == '-') {
-					str += expectedSign;
-					return PPToken(this->getPosition(), str, PPNUMBER);
-				} else {
-					string err = "Expected sign (+/-) after 'p','P','e','E' in"\
-								  "preprocessing-number.";
-					throw SyntaxException(err);
-				}
+#define D LEX_DONE
+static const unsigned char lexTransitions[LEX_STATES][CHAR_CLASSES] = {
+	//OTHER, SPACE, NEWLINE, LETTER, EXPONENT, DIGIT, DOT, SIGN, SLASH, STAR, NUL
+	{LEX_OTHER, LEX_SPACE, LEX_SPACE, LEX_IDENTIFIER, LEX_IDENTIFIER, \
+		LEX_NUMBER, LEX_OTHER, LEX_OTHER, LEX_SLASH, LEX_OTHER, LEX_OTHER}, //START
+	{D, D, D, D, D, D, D, D, D, D, D}, //SPACE
+	{D, D, D, D, D, D, D, D, D, D, D}, //OTHER
+	{D, D, D, LEX_IDENTIFIER, LEX_IDENTIFIER, LEX_IDENTIFIER, D, D, D, D, D},
+	{D, D, D, LEX_NUMBER, LEX_NUMBER_EXPONENT, LEX_NUMBER, LEX_NUMBER, D, D, D, \
+		D}, //NUMBER
+	{D, D, D, LEX_NUMBER, LEX_NUMBER_EXPONENT, LEX_NUMBER, LEX_NUMBER, \
+		LEX_NUMBER, D, D, D}, //NUMBER_EXPONENT, a sign may follow
+	{D, D, D, D, D, D, D, D, LEX_LINE_COMMENT, LEX_BLOCK_COMMENT, D}, //SLASH
+	{LEX_LINE_COMMENT, LEX_LINE_COMMENT, D, LEX_LINE_COMMENT, LEX_LINE_COMMENT, \
+		LEX_LINE_COMMENT, LEX_LINE_COMMENT, LEX_LINE_COMMENT, LEX_LINE_COMMENT, \
+		LEX_LINE_COMMENT, LEX_LINE_COMMENT}, //LINE_COMMENT, ends before new-line
+	{LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, \
+		LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, \
+		LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_STAR, \
+		LEX_BLOCK_COMMENT}, //BLOCK_COMMENT
+	{LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, \
+		LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, LEX_BLOCK_COMMENT, \
+		LEX_BLOCK_COMMENT, LEX_BLOCK_END, LEX_BLOCK_STAR, \
+		LEX_BLOCK_COMMENT}, //BLOCK_STAR
+	{D, D, D, D, D, D, D, D, D, D, D} //BLOCK_END
+};
+#undef D
+
+//What a lexeme which ends in a state is
+static const TokenKey lexKeys[LEX_STATES] = {OTHER, WHITESPACE, OTHER, \
+	IDENTIFIER, PPNUMBER, PPNUMBER, OTHER, WHITESPACE, WHITESPACE, WHITESPACE, \
+	WHITESPACE};
+
+Lexeme Lexer :: scan() {
+	size_t start = this->bufSource->offset();
+	unsigned int state = LEX_START;
+	while (true) {
+		unsigned char c = this->bufSource->peek();
+		unsigned int charClass = charClasses[c];
+		if (charClass == C_NUL && state != LEX_START && \
+				this->bufSource->empty()) {
+			//End of input, only a comment can be cut short by that
+			if (state == LEX_BLOCK_COMMENT || state == LEX_BLOCK_STAR) {
+				string err = "Unterminated comment at end of file";
+				throw SyntaxException(err);
 			}
-			current = source.get();
+			break;
 		}
-		return PPToken(this->getPosition(), str, PPNUMBER);
-	}
-	return PPToken(this->getPosition(), "", OTHER);
-}
-
-PPToken Lexer :: matchComment() {
-	string name = "";
-	char current = bufSource->get();
-	if (current == '/') {
-		current =bufSource->get();
-		if (current == '/') {
-			while (bufSource->get() != '\n') ;
-			bufSource->get();
-			return PPToken(this->getPosition(), " ", WHITESPACE);
-		} else if (current == '*') {
-			while (!(bufSource->get() == '*' && bufSource->get() == '/')) ;
-			bufSource->get();
-			return PPToken(this->getPosition(), " ", WHITESPACE);
+		unsigned int next = lexTransitions[state][charClass];
+		if (next == LEX_DONE) {
+			break;
 		}
+		state = next;
+		this->bufSource->get();
 	}
-	return PPToken(this->getPosition(), "", WHITESPACE);
+	return Lexeme(lexKeys[state], start, this->bufSource->offset() - start);
 }
 
-PPToken Lexer :: matchIdentifier() {
-	string name = "";
-	char current = bufSource->get();
-	if (isalpha(current) || current == '_')
-	{
-		name += current;
-		current = bufSource->get();
-		while (isalnum(current) || current == '_')
-		{
-			name += current;
-			current = bufSource->get();
+PPToken Lexer :: get() {
+	Lexeme lexeme = this->scan();
+	size_t start = lexeme.getStart();
+	if (this->splices != NULL) {
+		while (this->spliced < this->splices->size() && \
+				(*this->splices)[this->spliced] <= start) {
+			++this->spliced;
 		}
 	}
-	return PPToken(this->getPosition(), name, IDENTIFIER);
+	Position position(this->line + this->spliced, start - this->lineStart + 1);
+	unsigned int symbol;
+	if (lexeme.getKey() == WHITESPACE && lexeme.getLength() > 1) {
+		symbol = Interner::intern(" ", 1); //A comment
+		//Only block comments can have new-lines in them
+		this->scratch.resize(lexeme.getLength());
+		this->bufSource->copy(start, lexeme.getLength(), &this->scratch[0]);
+		size_t last = this->scratch.rfind('\n');
+		if (last != string::npos) {
+			this->line += count(this->scratch.begin(), this->scratch.end(), '\n');
+			this->lineStart = start + last + 1;
+		}
+	} else {
+		//Reuse the scratch string to not allocate for each lexeme
+		this->scratch.resize(lexeme.getLength());
+		this->bufSource->copy(lexeme.getStart(), lexeme.getLength(), \
+				&this->scratch[0]);
+		if (lexeme.getLength() == 1) {
+			//Most lexemes are a single character, keep their symbols at hand
+			unsigned char c = this->scratch[0];
+			if (this->singles[c] == 0) {
+				this->singles[c] = Interner::intern(this->scratch);
+			}
+			symbol = this->singles[c];
+		} else {
+			symbol = Interner::intern(this->scratch);
+		}
+	}
+	if (lexeme.getKey() == WHITESPACE && lexeme.getLength() == 1 && \
+			this->scratch[0] == '\n') {
+		++this->line;
+		this->lineStart = start + 1;
+	}
+	bufSource->reset();
+	return PPToken(position, symbol, lexeme.getKey());
 }
 
 bool isBaseChar(char c) {
 	return (isspace(c) || (isprint(c) && c != '$' && c != '@'));
 }
 
-PPToken Lexer :: matchHeaderName() {
-	string name = "";
-	char current = bufSource->get();
-	if (current == '<' || current == '\"')
-	{
-		char end = '>';
-		if (current == '\"') {
-			end = '\"';
-		}
-		name += current;
-		current = bufSource->get();
-		while (isBaseChar(current) && current != '\n' && current != end) {
-			name += current;
-			current = bufSource->get();
+Macro :: Macro(const string name, const list<PPToken>& body, \
+		const list<PPToken>& parameters) : name(name), \
+	parameters(parameters.begin(), parameters.end()) {
+	this->ops.reserve(body.size());
+	for (const PPToken& token : body) {
+		unsigned int k = 0;
+		if (token.getKey() == IDENTIFIER) {
+			while (k < this->parameters.size() && \
+					this->parameters[k].getSymbol() != token.getSymbol()) {
+				++k;
+			}
+		} else {
+			k = this->parameters.size();
 		}
-		if (current == end) {
-			name += current;
-			bufSource->get();
-			return PPToken(0, 0, name, HEADERNAME);
+		if (k < this->parameters.size()) {
+			this->ops.push_back(MacroOp(true, k));
 		} else {
-			return PPToken(0, 0, "", OTHER);
+			this->ops.push_back(MacroOp(false, this->tokens.size()));
+			this->tokens.push_back(token);
 		}
-	} else {
-		return PPToken(0, 0, name, HEADERNAME);
 	}
-	return PPToken(0, 0, name, HEADERNAME);
 }
 
-bool FunctionMacro :: bind(string key, list<PPToken>* replacement) {
-	auto search = this->argMap.find(key);
-	if (search ==  this->argMap.end()) {
-		//Can bind since the key wasn't found
-		this->argMap[key] = replacement;
-		return true;
-	} else {
+HideSet :: HideSet() {
+	this->store(vector<unsigned int>()); //The empty set is 0
+}
+
+HideSet& HideSet :: instance() {
+	static thread_local HideSet hideSet; //Its sets are only of this thread
+	return hideSet;
+}
+
+unsigned int HideSet :: store(const vector<unsigned int>& names) {
+	auto search = this->ids.find(names);
+	if (search != this->ids.end()) {
+		return search->second;
+	}
+	unsigned int id = this->sets.size();
+	this->sets.push_back(names);
+	this->ids[names] = id;
+	return id;
+}
+
+unsigned int HideSet :: add(unsigned int set, unsigned int name) {
+	HideSet& h = instance();
+	auto search = h.added.find(make_pair(set, name));
+	if (search != h.added.end()) {
+		return search->second;
+	}
+	vector<unsigned int> names = h.sets[set];
+	auto at = lower_bound(names.begin(), names.end(), name);
+	if (at == names.end() || *at != name) {
+		names.insert(at, name);
+	}
+	unsigned int id = h.store(names);
+	h.added[make_pair(set, name)] = id;
+	return id;
+}
+
+unsigned int HideSet :: intersect(unsigned int a, unsigned int b) {
+	if (a == b || b == 0) {
+		return b;
+	} else if (a == 0) {
+		return a;
+	}
+	HideSet& h = instance();
+	vector<unsigned int> names;
+	set_intersection(h.sets[a].begin(), h.sets[a].end(), h.sets[b].begin(), \
+			h.sets[b].end(), back_inserter(names));
+	return h.store(names);
+}
+
+unsigned int HideSet :: unite(unsigned int a, unsigned int b) {
+	if (b == 0 || a == b) {
+		return a;
+	} else if (a == 0) {
+		return b;
+	}
+	//Copied, as adding may move the sets
+	vector<unsigned int> names = instance().sets[b];
+	for (unsigned int name : names) {
+		a = add(a, name);
+	}
+	return a;
+}
+
+bool HideSet :: contains(unsigned int set, unsigned int name) {
+	if (set == 0) {
 		return false;
 	}
+	const vector<unsigned int>& names = instance().sets[set];
+	return binary_search(names.begin(), names.end(), name);
 }
 
-list<PPToken> FunctionMacro :: expand() {
-	list <PPToken> returnList = list<PPToken>();
-	for (const PPToken& c : this->getBody()) {
-		PPToken current = PPToken(c);
-		auto argSearch = argMap.find(current.getName());
-		if (argSearch == this->argMap.end()) {
-			//Since it's not an argument, just put in the current token
-			returnList.push_back(current);
-		} else {
-			//Put in the replacements for the current argument
-			for (PPToken p : *argSearch->second) {
-				returnList.push_back(p);
-			}	
+Token PostPPTokenizer :: get() {
+	Token token = this->next();
+	if (token.getKey() != STRINGLITERAL || this->drained) {
+		return token;
+	}
+	Token current = this->peekNext();
+	if (current.getKey() == STRINGLITERAL) {
+		//Drop the closing quote and append the next literal without its opening
+		this->literal = token.getName();
+		while (current.getKey() == STRINGLITERAL) {
+			const string& name = current.getName();
+			this->literal.pop_back();
+			this->literal.append(name, 1, string::npos);
+			this->next();
+			if (this->drained) {
+				break; //Nothing is left to append
+			}
+			current = this->peekNext();
 		}
+		return Token(this->getPosition(), Interner::intern(this->literal), \
+				STRINGLITERAL);
 	}
-	//Bookkeeping, clear all bound variables
-	this->bindable = list<PPToken>(this->arguments);
-	this->argMap.clear();
-	return returnList;
+	return Token(this->getPosition(), token.getSymbol(), STRINGLITERAL);
 }
 
-Token PostPPTokenizer :: get() {
+Token PostPPTokenizer :: next() {
+	if (this->lookingAhead) {
+		this->lookingAhead = false;
+		return this->lookahead;
+	}
+	return this->clean();
+}
+
+Token PostPPTokenizer :: peekNext() {
+	if (!this->lookingAhead) {
+		this->lookahead = this->clean();
+		this->lookingAhead = true;
+	}
+	return this->lookahead;
+}
+
+//! Skips white-space, and tells if only white-space follows the token
+/*! Whether the buffer finds its source empty depends on how far ahead was
+ * peeked, so the tokens left are looked at instead. Otherwise the last
+ * tokens could be dropped, or a comment at the end be taken as a token.
+ */
+Token PostPPTokenizer :: clean() {
+	Token current = this->classify();
+	while (current.getKey() == WHITESPACE && this->source.has(0)) {
+		current = this->classify();
+	}
+	unsigned int ahead = 0;
+	while (this->source.has(ahead) && \
+			this->source.peek(ahead).getKey() == WHITESPACE) {
+		++ahead;
+	}
+	this->drained = !this->source.has(ahead);
+	return current;
+}
+
+Token PostPPTokenizer :: classify() {
 	string longest = "";
 	string testStr = "";
 	PPTokenInternal testToken;
@@ -438,12 +834,12 @@ PPTokenInternal PostPPTokenizer :: matchCharacterConstant() {
 		first = source.peek(1); //Double quote should be here, if it is a match
 		peekInt = 2;
 	}
-	if (first.getName() == "'") {
+	if (first.getSymbol() == SYM_APOSTROPHE) {
 		str += first.getName();
 		PPToken token = source.peek(peekInt);
-		while (token.getName() != "'") {
+		while (token.getSymbol() != SYM_APOSTROPHE) {
 			token = source.peek(peekInt);
-			if (token.getName() == "\n") {
+			if (token.getSymbol() == SYM_NEWLINE) {
 				string err = "Found new-line while scanning string literal";
 				throw SyntaxException(err);
 			} 
@@ -469,12 +865,12 @@ PPTokenInternal PostPPTokenizer :: matchStringLiteral() {
 		first = source.peek(1); //Double quote should be here, if it is a match
 		peekInt = 2;
 	}
-	if (first.getName() == "\"") {
+	if (first.getSymbol() == SYM_QUOTE) {
 		str += first.getName();
 		PPToken token = source.peek(peekInt);
-		while (token.getName() != "\"") {
+		while (token.getSymbol() != SYM_QUOTE) {
 			token = source.peek(peekInt);
-			if (token.getName() == "\n") {
+			if (token.getSymbol() == SYM_NEWLINE) {
 				string err = "Found new-line while scanning string literal";
 				throw SyntaxException(err);
 			} 
@@ -491,165 +887,36 @@ PPTokenInternal PostPPTokenizer :: matchStringLiteral() {
 }
 
 PPTokenInternal PostPPTokenizer :: matchKeyword() {
-	unsigned int used = 1;
 	PPToken token = source.peek();
-	string str = token.getName();
-	if (str == "_") {
-		str += source.peek(1).getName();
-		used = 2;
-	}
-	auto search = this->keywordMap.find(str);
-	if (search != this->keywordMap.end()) {
-		return PPTokenInternal(source.getPosition(), str, KEYWORD, used);
+	const string& str = token.getName();
+	if (isKeyword(str.data(), str.length())) {
+		return PPTokenInternal(source.getPosition(), token.getSymbol(), \
+				KEYWORD, 1);
 	}
 	return PPTokenInternal(source.getPosition(), "", OTHER, 0);
 }
 
 PPTokenInternal PostPPTokenizer :: matchPunctuator() {
-	unsigned int used = 1;
-	unsigned int i = 0;
-	bool matched = false;
-	PPToken token;
-	PPTokenInternal returnToken = PPTokenInternal(this->getPosition(), "", \
-			OTHER, 0);
-	string str = "";
-	for (i = 0; i < 4; ++i) {
-		token = source.peek(i);
-		str += token.getName();
-		if (str.length() > 4) break;
-		auto search = this->punctuatorMap.find(str);
-		if (search != this->punctuatorMap.end()) {
-			matched = true;
-			returnToken = PPTokenInternal(this->getPosition(), str, \
-					PUNCTUATOR, used+i);
+	//Punctuators are made of single character preprocessing tokens, gather the
+	//characters of up to four of them. Tokens are peeked until four characters
+	//have been seen, even past a token which ends the punctuator, since how far
+	//ahead is peeked decides when the buffer finds the source empty.
+	char chars[4];
+	unsigned int length = 0;
+	size_t seen = 0;
+	for (unsigned int i = 0; i < 4 && seen <= 4; ++i) {
+		PPToken token = source.peek(i);
+		const string& name = token.getName();
+		if (length == i && name.length() == 1) {
+			chars[length++] = name[0];
 		}
-		
+		seen += name.length();
 	}
-	if (matched) {
-		return returnToken;
+	unsigned int used = punctuatorLength(chars, length);
+	if (used > 0) {
+		return PPTokenInternal(this->getPosition(), \
+				Interner::intern(chars, used), PUNCTUATOR, used);
 	} else {
 		return PPTokenInternal(source.getPosition(), "", OTHER, 0);
 	}
 }
-
-void PostPPTokenizer :: initPunctuatorMap() {
-	this->punctuatorMap["["] = "[";
-	this->punctuatorMap["]"] = "]";
-	this->punctuatorMap["("] = "(";
-	this->punctuatorMap[")"] = ")";
-	this->punctuatorMap["{"] = "{";
-	this->punctuatorMap["}"] = "}";
-	this->punctuatorMap["."] = ".";
-	this->punctuatorMap["->"] = "->";
-	this->punctuatorMap["++"] = "++";
-	this->punctuatorMap["--"] = "--";
-	this->punctuatorMap["&"] = "&";
-	this->punctuatorMap["*"] = "*";
-	this->punctuatorMap["+"] = "+";
-	this->punctuatorMap["-"] = "-";
-	this->punctuatorMap["~"] = "~";
-	this->punctuatorMap["!"] = "!";
-	this->punctuatorMap["/"] = "/";
-	this->punctuatorMap["%"] = "%";
-	this->punctuatorMap["<<"] = "<<";
-	this->punctuatorMap[">>"] = ">>";
-	this->punctuatorMap["<"] = "<";
-	this->punctuatorMap[">"] = ">";
-	this->punctuatorMap["<="] = "<=";
-	this->punctuatorMap[">="] = ">=";
-	this->punctuatorMap["=="] = "==";
-	this->punctuatorMap["!="] = "!=";
-	this->punctuatorMap["^"] = "^";
-	this->punctuatorMap["|"] = "|";
-	this->punctuatorMap["&&"] = "&&";
-	this->punctuatorMap["||"] = "||";
-	this->punctuatorMap["?"] = "?";
-	this->punctuatorMap[":"] = ":";
-	this->punctuatorMap[";"] = ";";
-	this->punctuatorMap["..."] = "...";
-	this->punctuatorMap["="] = "=";
-	this->punctuatorMap["*="] = "*=";
-	this->punctuatorMap["/="] = "/=";
-	this->punctuatorMap["%="] = "%=";
-	this->punctuatorMap["+="] = "+=";
-	this->punctuatorMap["-="] = "-=";
-	this->punctuatorMap["<<="] = "<<=";
-	this->punctuatorMap[">>="] = ">>=";
-	this->punctuatorMap["&="] = "&=";
-	this->punctuatorMap["^="] = "^=";
-	this->punctuatorMap["|="] = "|=";
-	this->punctuatorMap[","] = ",";
-	this->punctuatorMap["#"] = "#";
-	this->punctuatorMap["##"] = "##";
-	this->punctuatorMap["<:"] = "<:";
-	this->punctuatorMap[":>"] = ":>";
-	this->punctuatorMap["<%"] = "<%";
-	this->punctuatorMap["%>"] = "%>";
-	this->punctuatorMap["%:"] = "%:";
-	this->punctuatorMap["%:%:"] = "%:%:";
-}
-
-void PostPPTokenizer :: initKeywordMap() {
-	this->keywordMap["auto"] = "auto";
-	this->keywordMap["break"] = "break";
-	this->keywordMap["case"] = "case";
-	this->keywordMap["char"] = "char";
-	this->keywordMap["const"] = "const";
-	this->keywordMap["continue"] = "continue";
-	this->keywordMap["default"] = "default";
-	this->keywordMap["do"] = "do";
-	this->keywordMap["double"] = "double";
-	this->keywordMap["else"] = "else";
-	this->keywordMap["enum"] = "enum";
-	this->keywordMap["extern"] = "extern";
-	this->keywordMap["float"] = "float";
-	this->keywordMap["for"] = "for";
-	this->keywordMap["goto"] = "goto";
-	this->keywordMap["if"] = "if";
-	this->keywordMap["inline"] = "inline";
-	this->keywordMap["int"] = "int";
-	this->keywordMap["long"] = "long";
-	this->keywordMap["register"] = "register";
-	this->keywordMap["restrict"] = "restrict";
-	this->keywordMap["return"] = "return";
-	this->keywordMap["short"] = "short";
-	this->keywordMap["signed"] = "signed";
-	this->keywordMap["sizeof"] = "sizeof";
-	this->keywordMap["static"] = "static";
-	this->keywordMap["struct"] = "struct";
-	this->keywordMap["switch"] = "switch";
-	this->keywordMap["typedef"] = "typedef";
-	this->keywordMap["union"] = "union";
-	this->keywordMap["unsigned"] = "unsigned";
-	this->keywordMap["void"] = "void";
-	this->keywordMap["volatile"] = "volatile";
-	this->keywordMap["while"] = "while";
-	this->keywordMap["_Alignas"] = "_Alignas";
-	this->keywordMap["_Alignof"] = "_Alignof";
-	this->keywordMap["_Atomic"] = "_Atomic";
-	this->keywordMap["_Bool"] = "_Bool";
-	this->keywordMap["_Complex"] = "_Complex";
-	this->keywordMap["_Generic"] = "_Generic";
-	this->keywordMap["_Imaginary"] = "_Imaginary";
-	this->keywordMap["_Noreturn"] = "_Noreturn";
-	this->keywordMap["_Static_assert"] = "_Static_assert";
-	this->keywordMap["_Thread_local"] = "_Thread_local";
-}
-
-Token StrLitConCat :: get() {
-	Token token = source.get();
-	if (token.getKey() == STRINGLITERAL) {
-		Token current = source.peek();
-		string str = token.getName();
-		while (current.getKey() == STRINGLITERAL) {
-			str.pop_back();
-			str += current.getName().substr(1, current.getName().length());
-			source.get();
-			current = source.peek();
-		}
-		return Token(this->getPosition(), str, STRINGLITERAL);
-	} else {
-		return token;
-	}
-}
-
@@ -5,164 +5,588 @@
 #include <deque>
 #include <list>
 #include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <sys/stat.h>
 #include "syntax.h"
+#include "keywords.h"
+#include "includes.h"
+#include "expression.h"
+#include "pch.h"
+#include "deps.h"
+#include "cache.h"
+#include "prefetch.h"
 
 using namespace std;
 
 
+//! A line splicer performs translation phases 1 and 2
+/*! Trigraph sequences are replaced and backslash-newline pairs are removed 
+ * lazily, as characters are requested, so the mapped file is never copied.
+ * Only '?' and '\\' can start either, so the file is scanned ahead in blocks
+ * for those two bytes and the clean run before them is handed out as is.
+ */
+class LineSplicer : public Phase<char, char> {
+	public:
+		LineSplicer(MappedFileSource* s) : Phase(s), data(s->getData()), \
+										   length(s->size()), pos(0), \
+										   removed(0), cleanEnd(0), \
+										   exhausted(false) {}
+		char get();
+		bool empty() {return exhausted;}
+		size_t getBatch(char* out, size_t max);
+		//Offset in the output of the character after each splice, in order
+		const vector<size_t>& getSplices() const {return splices;}
+	private:
+		const char* data;
+		size_t length;
+		size_t pos;
+		size_t removed; //Bytes read but not handed out, pos - removed is output
+		vector<size_t> splices;
+		size_t cleanEnd; //No '?' or '\\' in [pos, cleanEnd)
+		bool exhausted; //Set once a get() has been attempted past the end
+		char trigraph(size_t& at); //Phase 1 character at 'at', moves 'at' past it
+		size_t scan(size_t from); //Index of next '?' or '\\' at or after from
+};
+
+//! The kind and extent of a lexeme, as found by Lexer::scan()
+/*! The extent is given as positions in the BufferedSource that was lexed, see
+ * BufferedSource::offset(). Comments are WHITESPACE lexemes starting with '/'.
+ */
+class Lexeme {
+	public:
+		Lexeme(TokenKey key, size_t start, size_t length) : key(key), \
+															start(start), \
+															length(length) {}
+		TokenKey getKey() {return key;}
+		size_t getStart() {return start;}
+		size_t getLength() {return length;}
+	private:
+		TokenKey key;
+		size_t start;
+		size_t length;
+};
+
 /*! The source class represents a source of the type,
  * e.g. a stream such as istream.
  */
 //! A lexer performs translation phase 3
+/*! Lexemes are found in a single pass by a DFA, which looks up the class of
+ * each character in a table and the next state in a table indexed by state and
+ * class. Like before, the character after a lexeme is fetched but left unread,
+ * and the buffer is reset to its beginning after each get().
+ */
 class Lexer : public Phase<char, PPToken> {
 	public:
-		Lexer(BufferedSource<char>* s) : Phase(s), bufSource(s) {}
+		Lexer(BufferedSource<char>* s, const vector<size_t>* splices = NULL) : \
+			Phase(s), bufSource(s), splices(splices), spliced(0), line(1), \
+			lineStart(0) {}
 		PPToken get();
 		bool empty() {return bufSource->empty();}
-		PPToken matchHeaderName();
-		PPToken matchComment();
-		PPToken matchIdentifier();
-		PPToken matchPPNumber();
+		size_t getBatch(PPToken* out, size_t max) {
+			return getEach(this, out, max);
+		}
+		Lexeme scan(); //Reads the next lexeme, without making a token of it
 	private:
 		BufferedSource<char>* bufSource;
+		string scratch; //Characters of the lexeme being interned
+		unsigned int singles[256] = {}; //Symbol of each character, 0 if unknown
+		//Tokens are given the line and column they start at in the file, which
+		//needs to know where lines were spliced, see LineSplicer::getSplices()
+		const vector<size_t>* splices;
+		size_t spliced; //Number of splices before the current lexeme
+		unsigned int line; //Not counting spliced lines
+		size_t lineStart; //Offset of the first character of the line
+};
+
+//! Sets of names of macros which must not be expanded again (C11 6.10.3.4)
+/*! Each set is stored once and is referred to by its index, the empty set
+ * being 0, so a token being expanded only needs an unsigned int to carry its
+ * hide set. A set is a sorted vector of interned names.
+ */
+class HideSet {
+	public:
+		static unsigned int add(unsigned int set, unsigned int name);
+		static unsigned int intersect(unsigned int a, unsigned int b);
+		static unsigned int unite(unsigned int a, unsigned int b);
+		static bool contains(unsigned int set, unsigned int name);
+	private:
+		HideSet();
+		static HideSet& instance();
+		unsigned int store(const vector<unsigned int>& names);
+		vector<vector<unsigned int>> sets; //Indexed by set
+		map<vector<unsigned int>, unsigned int> ids;
+		map<pair<unsigned int, unsigned int>, unsigned int> added; //Memo of add()
 };
 
+//! Where an argument of a macro invocation lies among the collected tokens
+class TokenSpan {
+	public:
+		TokenSpan(size_t begin, size_t end) : begin(begin), end(end) {}
+		size_t getBegin() const {return begin;}
+		size_t getEnd() const {return end;}
+	private:
+		size_t begin;
+		size_t end; //One past the last token of the argument
+};
+
+//! One step of expanding a macro, either a token of the body or a parameter
+class MacroOp {
+	public:
+		MacroOp(bool parameter, unsigned int index) : parameter(parameter), \
+													  index(index) {}
+		bool isParameter() const {return parameter;}
+		//Index of the parameter, or of the token among the non-parameters
+		unsigned int getIndex() const {return index;}
+	private:
+		bool parameter;
+		unsigned int index;
+};
+
+//! A macro whose body is compiled into MacroOps when it is defined
+/*! The parameters are looked up once, at #define, so expanding a macro is a
+ * walk over its ops which takes either a token of the body or the tokens of
+ * an argument, see Preprocessor::next().
+ */
 class Macro {
 	public:
-		Macro(const string name, list<PPToken>& list) : name(name), body(list) {}
-		~Macro() { }
-		virtual list<PPToken> expand() = 0;
+		Macro(const string name, const list<PPToken>& body, \
+				const list<PPToken>& parameters);
+		virtual ~Macro() {}
+		const vector<MacroOp>& getOps() const {return this->ops;}
+		const PPToken& getToken(unsigned int index) const {return tokens[index];}
+		const PPToken& getParameter(unsigned int k) const {return parameters[k];}
+		size_t getParameterCount() const {return this->parameters.size();}
 	protected:
 		const string getName() {return this->name;}
-		const list<PPToken>& getBody() {return this->body;}
 	private:
 		const string name;
-		const list<PPToken>& body;
+		vector<PPToken> tokens; //The tokens of the body which are not parameters
+		vector<PPToken> parameters;
+		vector<MacroOp> ops;
 };
 
 class ObjectMacro : public Macro {
 	public:
-		ObjectMacro(const string name, list<PPToken>& l) : Macro(name, l) {}
-		list<PPToken> expand() {return list<PPToken>(this->getBody());}
+		ObjectMacro(const string name, const list<PPToken>& body) : \
+			Macro(name, body, list<PPToken>()) {}
 };
 
 class FunctionMacro : public Macro {
 	public:
-		FunctionMacro(const string name, list<PPToken>& l,\
-			   	list<PPToken>& arg_names) : Macro(name, l),\
-										   	arguments(arg_names),\
-											bindable(*new list<PPToken>(arg_names))	{
-											argMap = map<string, list<PPToken>*>();
-											}
-		bool bind(list<PPToken>* replacement) {
-			if (bindable.empty()) {
+		FunctionMacro(const string name, const list<PPToken>& body, \
+				const list<PPToken>& parameters) : Macro(name, body, parameters) {}
+};
+
+
+//! An #if, #ifdef, #ifndef, #elif, #else or #endif of a file
+class Conditional {
+	public:
+		enum Kind {IF, IFDEF, IFNDEF, ELIF, ELSE, ENDIF};
+		Conditional(Kind kind, size_t at, size_t after, size_t offset) : \
+			kind(kind), at(at), after(after), offset(offset) {}
+		Kind getKind() const {return kind;}
+		size_t getAt() const {return at;}
+		size_t getAfter() const {return after;}
+		size_t getOffset() const {return offset;}
+	private:
+		Kind kind;
+		size_t at; //Index of the '#'
+		size_t after; //Index of the token after the name of the directive
+		size_t offset; //Of the '#' in the file, after lines have been spliced
+};
+
+//! The preprocessing tokens of a file, and the include guard around them
+/*! A file is guarded if, apart from white-space, it starts with '#ifndef X'
+ * directly followed by '#define X' and ends with the #endif closing the
+ * #ifndef. Then only the tokens inside the guard need to be preprocessed, and
+ * none if X is already defined.
+ *
+ * The conditional directives at the start of a line are indexed as well, so
+ * that a group which is not to be preprocessed can be skipped by going from
+ * directive to directive, without looking at the tokens in between.
+ */
+class LexedFile {
+	public:
+		//Takes the index and the offset of each '#' which starts a line
+		LexedFile(vector<PPToken>* tokens, \
+				const vector<pair<size_t, size_t>>& directives);
+		virtual ~LexedFile() {delete tokens;}
+		const vector<PPToken>* getTokens() const {return tokens;}
+		const string& getGuard() const {return guard;} //Empty if not guarded
+		size_t getGuardedBegin() const {return guardedBegin;}
+		size_t getGuardedEnd() const {return guardedEnd;}
+		//In the order they appear in the file
+		const vector<Conditional>& getConditionals() const {return conditionals;}
+		//The header name of each #include, with its quotes or angle brackets.
+		//Those made by macros are left out.
+		const vector<string>& getIncludes() const {return includes;}
+	protected:
+		LexedFile(vector<PPToken>* tokens) : tokens(tokens), guard(""), \
+			guardedBegin(0), guardedEnd(0) {}
+		//Indexes the directive whose '#' is at at, and at offset in the file.
+		//The first token of the vector is at base in the file.
+		void indexDirective(size_t at, size_t offset, size_t base);
+		vector<PPToken>* tokens;
+	private:
+		string guard;
+		size_t guardedBegin; //First token after the #ifndef line
+		size_t guardedEnd; //The '#' of the closing #endif
+		vector<Conditional> conditionals;
+		vector<string> includes;
+		void findGuard();
+		void headerName(size_t at);
+		size_t skipWhiteSpace(size_t at, bool newLines) const;
+		size_t directive(size_t at, unsigned int name) const;
+};
+
+//! The preprocessing tokens of a file, lexed a line at a time when needed
+/*! Only a window of the tokens is kept, so a file of any size is read in
+ * bounded memory. Tokens and conditionals are still indexed from the start of
+ * the file, the first token in the window is the one at getBase(). No include
+ * guard is looked for, as that takes the whole file, so this is only used for
+ * the main file.
+ */
+class TokenStream : public LexedFile {
+	public:
+		TokenStream(const string& filename);
+		//Lexes one more line, false if the file has ended. The tokens before
+		//keep are no longer needed and may be dropped from the window.
+		bool more(size_t keep);
+		size_t getBase() const {return base;}
+		size_t getLexed() const {return base + tokens->size();}
+	private:
+		static const size_t minTrim = 1 << 14; //Tokens dropped at least
+		MappedFileSource source;
+		LineSplicer splicer;
+		BufferedSource<char> buffer;
+		Lexer lexer;
+		size_t base; //Index in the file of the first token of the window
+};
+
+//! Replays the preprocessing tokens of a file which has been lexed
+/*! Works like the Lexer reading from a BufferedSource did: peek() is what
+ * Lexer::get() used to be and advance() is trimming the buffer after it. So
+ * peek() returns the same token until advance() is called, and advance() does
+ * nothing unless a token has been peeked since the last advance(). The source
+ * is empty once the last token has been peeked.
+ */
+class TokenReplay : public Source<PPToken> {
+	public:
+		TokenReplay(const vector<PPToken>* tokens, size_t begin, size_t end) : \
+			tokens(tokens), stream(NULL), base(0), end(end), next(begin), \
+			lexed(begin) {}
+		//Replays the tokens as the stream lexes them
+		TokenReplay(TokenStream* stream) : tokens(stream->getTokens()), \
+			stream(stream), base(0), end(0), next(0), lexed(0) {}
+		PPToken get() {
+			PPToken token = this->peek();
+			this->advance();
+			return token;
+		}
+		PPToken peek();
+		void advance() {
+			if (this->lexed > this->next) {
+				++this->next;
+			}
+		}
+		bool empty() {return this->lexed >= this->end && !this->more();}
+		PPTokenInternal matchHeaderName();
+		size_t position() const {return next;} //Index of the token to peek
+		size_t getEnd() const {return end;} //Of the tokens lexed so far
+		//Has the stream lex another line, false if there is none
+		bool more() {
+			if (this->stream == NULL || !this->stream->more( \
+						this->next > margin ? this->next - margin : 0)) {
 				return false;
 			}
-			PPToken bindTo = this->bindable.front();
-			bindable.pop_front();
-			return this->bind(bindTo.getName(), replacement);
+			this->base = this->stream->getBase();
+			this->end = this->stream->getLexed();
+			return true;
 		}
-		bool bind(PPToken key, list<PPToken>* replacement) {
-			return this->bind(key.getName(), replacement);
+		void seek(size_t at) { //Continue with the token at at, not yet peeked
+			this->next = at;
+			this->lexed = at;
 		}
-		bool bind(string key, list<PPToken>* replacement);
-		list<PPToken> expand();
 	private:
-		list<PPToken>& arguments;
-		list<PPToken>& bindable;
-		map<string, list<PPToken>*> argMap;
+		//Tokens before the one to peek which may still be seeked back to
+		static const size_t margin = 1 << 12;
+		const vector<PPToken>* tokens; //Owned by the TokenCache or the stream
+		TokenStream* stream; //NULL if all tokens were lexed up front
+		size_t base; //Index of the first of the tokens
+		size_t end; //Index after the last token to replay
+		size_t next; //Index of the token to peek
+		size_t lexed; //Index after the last token that has been peeked
 };
 
+//! A process-wide cache of the preprocessing tokens of each file
+/*! Files are lexed once and their tokens are replayed on every later #include
+ * of the same file. Entries are keyed by the canonical path of the file and
+ * are lexed again if the modification time or the size of the file changes.
+ *
+ * Files may be looked up from several threads. A file is lexed outside of the
+ * lock, and a thread looking up a file which is being lexed waits for it.
+ */
+class TokenCache {
+	public:
+		static const LexedFile* lookup(const string& filename);
+		//The canonical path of the file, or the empty string if there is no
+		//such file. Each name is only resolved the first time.
+		static string canonicalPath(const string& filename);
+		static unsigned int getHits() {return instance().hits;}
+		static unsigned int getMisses() {return instance().misses;}
+		//Only keep the lines of directives, for finding dependencies
+		static void setDirectivesOnly(bool only) {instance().directivesOnly = only;}
+		static bool isDirectivesOnly() {return instance().directivesOnly;}
+		static LexedFile* lexDirectives(const string& filename);
+	private:
+		struct Entry {
+			time_t modified;
+			long modifiedNanoseconds;
+			off_t size;
+			LexedFile* file;
+		};
+		TokenCache() : hits(0), misses(0), directivesOnly(false) {}
+		static TokenCache& instance();
+		static LexedFile* lex(const string& filename);
+		//Keyed by canonical path, the file is NULL while it is being lexed
+		map<string, Entry> entries;
+		map<string, string> paths; //Canonical path of each name looked up
+		mutex lock;
+		condition_variable lexed; //Notified when a file has been lexed
+		unsigned int hits;
+		unsigned int misses;
+		bool directivesOnly;
+};
 
 //! A preprocessor performs translation phase 4
-class Preprocessor : public Phase<char, PPToken> {
+/*! Included files are preprocessed by a Preprocessor of their own, which
+ * shares the macros of the one including it. Their tokens are read without
+ * expanding macros, so that only the outermost Preprocessor expands them.
+ */
+class Preprocessor : public Phase<PPToken, PPToken> {
 	public:
-		Preprocessor(string filename);
-		//Preprocessor(Lexer* s) : Phase(s), lexer(s) {}
+		//Starts with the header given by --include-pch, if there is one. The
+		//file is lexed as it is read if streamed, otherwise it is cached like
+		//an included one and its include guard is kept.
+		Preprocessor(string filename, bool streamed = true);
 		PPToken get();
-		bool empty() {return lexer->empty();}
+		bool empty() {
+			return precompiledAt == precompiledEnd && pending.empty() && \
+				expansions.empty() && replay->empty() && \
+				(!usingCache || cache->empty());
+		}
+		//The file the last token came from, i.e. the innermost included one
+		const string& getFilename() {
+			if (fromPrecompiled) {
+				return precompiled->getHeader();
+			}
+			return usingCache ? cache->getFilename() : filename;
+		}
+		//An included file which was entered or left
+		struct FileChange {
+			bool entered; //Otherwise left, for the file which included it
+			string filename; //Of the file read from then on
+			unsigned int line; //Where it is read from
+			bool system; //True if the file is a system header
+		};
+		//The files entered and left since the vector was cleared, in order.
+		//The precompiled header counts as included. Clearing is up to the
+		//reader of the tokens.
+		vector<FileChange>& getFileChanges() {return *changes;}
+		//Preprocesses all of the file and writes it as a precompiled header
+		void precompile(const string& outputname);
+		size_t getBatch(PPToken* out, size_t max) {
+			return getEach(this, out, max);
+		}
 		~Preprocessor() {
-			delete lexSource;
-			delete bufLexSource;
-			delete lexer;
+			delete replay;
+			delete stream;
 			if (usingCache) {
 				delete cache;
 			}
 		}
+		//Every file named by an #include since reset(), in order
+		static const vector<string>& getIncludedFiles() {return includedFiles;}
+		//Forgets the files included, before preprocessing another file
+		static void reset() {
+			includedFiles.clear();
+			onceFiles.clear();
+		}
+		//Number of #includes skipped because of a guard or #pragma once
+		static unsigned int getSkippedIncludes() {return skippedIncludes;}
+		//Number of bytes in groups which were not preprocessed
+		static size_t getSkippedBytes() {return skippedBytes;}
 	private:
-		Lexer* lexer;
 		string filename; //Could be removed? Used only for reporting errors
-		ifstream filestream;
-		stringstream stream12;
-		stringstream stream23;
-		StreamSource<char>* lexSource;
-		BufferedSource<char>* bufLexSource;
+		const LexedFile* file;
+		TokenStream* stream; //The file if it is streamed, otherwise NULL
+		TokenReplay* replay;
 		bool usingCache;
 		Preprocessor* cache;
-		bool expandingMacro;
-		list<PPToken>* macroCache;
+		unsigned int includeLine; //Of the #include which began 'cache'
+		bool system; //True if the file is a system header
+		vector<FileChange> fileChanges;
+		vector<FileChange>* changes; //Those of the outermost Preprocessor
+		PrecompiledHeader* precompiled; //Its tokens come first, NULL if none
+		size_t precompiledAt; //Index of the next token of the header
+		size_t precompiledEnd;
+		bool fromPrecompiled; //True if the last token was one of the header
+		//A macro being expanded, and where in it the expansion is
+		struct Expansion {
+			const Macro* macro;
+			size_t op; //Index of the next op
+			size_t argAt; //Next token of the argument being substituted
+			size_t argEnd; //End of that argument, argAt == argEnd if none
+			unsigned int hidden; //Hide set of the tokens of the body
+			size_t arguments; //Index of the first argument in 'arguments'
+			size_t argumentCount;
+			size_t arena; //Size of the arena before the arguments were added
+			Position position; //Of the name, given to the tokens of the body
+		};
+		vector<Expansion> expansions; //Nested expansions, innermost last
+		vector<PPToken> arena; //Arguments of the macros being expanded
+		vector<unsigned int> arenaHidden; //Hide set of each token in the arena
+		vector<TokenSpan> arguments; //Where each argument is in the arena
+		bool collecting; //True while the arguments of an invocation are read
+		vector<PPToken> pending; //Tokens put back after looking ahead, last first
+		vector<unsigned int> pendingHidden;
+		vector<PPToken> lookahead; //Reused when looking for '(' after a name
+		vector<unsigned int> lookaheadHidden;
+		//An argument being expanded on its own, before it is substituted
+		struct Isolation {
+			size_t at; //Next token of the argument in the arena
+			size_t end;
+			size_t expansions; //Size of 'expansions' when it was begun
+			size_t pending; //Size of 'pending' when it was begun
+		};
+		vector<Isolation> isolations; //Innermost last
+		vector<PPToken> expanded; //Expansions of arguments, until substituted
+		vector<unsigned int> expandedHidden;
+		bool inDirective; //True while the macros of an #if line are expanded
+		vector<bool> groups; //For each #if being read, if its #else was seen
+		PPToken next(unsigned int& hidden); //The next token, not expanded
+		bool expand(PPToken& token, unsigned int& hidden);
+		bool exhausted(); //True if there is nothing left to expand
+		void expandArguments(size_t first, size_t arena, unsigned int hidden);
+		bool invoke(const FunctionMacro* macro, const PPToken& name, \
+				unsigned int hidden);
+		void settle();
 		map<string, Macro*>* macroMap;
 		PPToken include();
 		PPToken define();
 		PPToken undef();
+		PPToken pragma();
+		PPToken ifGroup(unsigned int kind, size_t hash); //Kind is a KnownSymbol
+		PPToken elseGroup(unsigned int kind, size_t hash);
+		PPToken endif();
+		PPToken skipGroup(size_t hash, bool taken);
+		bool condition(unsigned int kind, PPToken& newline);
+		PPToken skipLine(); //Returns the new-line ending the line
 		PPToken unexpandedGet(); //A get function that does not expand macros
-		
+		Preprocessor(string filename, const LexedFile* file, \
+				map<string, Macro*>* macroMap);
+		Preprocessor(string filename, const LexedFile* file, \
+				map<string, Macro*>* macroMap, TokenReplay* replay);
+		//The stream is the file, or NULL if the file is cached
+		Preprocessor(string filename, TokenStream* stream, \
+				map<string, Macro*>* macroMap);
+		Preprocessor(string filename, TokenStream* stream, \
+				const LexedFile* file, map<string, Macro*>* macroMap);
+		static TokenReplay* replayGuarded(const LexedFile* file, \
+				map<string, Macro*>* macroMap);
+		static Macro* findMacro(map<string, Macro*>* macroMap, \
+				const string& name);
+		//Both are keyed by the canonical path, see TokenCache::canonicalPath()
+		//These are of the unit, so each thread scanning units has its own
+		static thread_local map<string, string> guardMacros; //Of each file
+		static thread_local set<string> onceFiles; //Have had #pragma once
+		static thread_local vector<string> includedFiles;
+		//Names the precompiled header does not define, the same for every unit
+		static thread_local set<string> notPrecompiled;
+		static atomic<unsigned int> skippedIncludes;
+		static atomic<size_t> skippedBytes;
 };
 
+//! Turns preprocessing tokens into the tokens the parser reads
+/*! Performs what is left of translation phases 6 and 7 in one pass: tokens are
+ * classified, white-space is dropped and adjacent string literals are
+ * concatenated. The concatenated literal is built in a reused buffer and is
+ * only interned once.
+ */
 class PostPPTokenizer : public Phase<PPToken, Token> {
 	public:
 		PostPPTokenizer(BufferedSource<PPToken>& source) : Phase(source), \
 														   source(source), \
-														   keywordMap\
-														   (map<string,string>()) {
-															   initKeywordMap();
-															   initPunctuatorMap();
-														   }
+														   lookingAhead(false), \
+														   drained(false) {}
 		Token get();
-		bool empty() {return this->source.empty();}
+		bool empty() {return this->drained && !this->lookingAhead;}
+		size_t getBatch(Token* out, size_t max) {return getEach(this, out, max);}
 	private:
 		BufferedSource<PPToken>& source;
+		Token classify(); //The next token, white-space included
+		Token clean(); //The next token which is not white-space
+		Token next(); //The token after the ones that have been returned
+		Token peekNext(); //Like next(), but the token is kept for later
 		PPTokenInternal matchKeyword();
 		PPTokenInternal matchPunctuator();
 		PPTokenInternal matchStringLiteral();
 		PPTokenInternal matchConstant();
 		PPTokenInternal matchCharacterConstant();
-		map<string, string> keywordMap;
-		void initKeywordMap(); //Fills the keywordMap with keywords
-		map<string, string> punctuatorMap;
-		void initPunctuatorMap();
-};
-
-class WhiteSpaceCleaner : public Phase<Token, Token> {
-	public:
-		WhiteSpaceCleaner(Source<Token>& source) : Phase(source) {}
-		bool empty() {return this->source.empty();}
-		Token get() {
-			Token current = source.get();
-			while (current.getKey() == WHITESPACE) {
-				current = source.get();
-				if (source.empty()) {
-					break;
-				}
-			}
-			return current;
-		}
+		Token lookahead; //Valid if lookingAhead
+		bool lookingAhead;
+		bool drained; //Only white-space was left after the last token cleaned
+		string literal; //Buffer for concatenating string literals
 };
 
-class StrLitConCat : public Phase<Token, Token> {
+//! Writes the output of a Preprocessor as text, for -E
+/*! Tokens are copied into a large buffer which is written with write(2) when
+ * it is full, so the output itself takes no more memory than that. The main
+ * file is read through a TokenStream, so only the headers are held by the
+ * TokenCache for the whole run. Line
+ * markers like those of GCC, '# 12 "file.h" 1', are written when the
+ * Preprocessor enters or leaves an included file, with flag 3 in a system
+ * header, or when lines were left out, e.g. by #if. A gap of a few lines is
+ * filled with empty lines instead.
+ */
+class PreprocessedWriter : public Consumer<PPToken> {
 	public:
-		StrLitConCat(BufferedSource<Token>& source) : Phase(source), \
-													  source(source) {}
-		bool empty() {return this->source.empty();}
-		Token get();
+		PreprocessedWriter(Preprocessor& preprocessor, int fd) : \
+			preprocessor(preprocessor), fd(fd), buffer(bufferSize), used(0), \
+			line(1), lineStart(true) {
+			this->files.push_back(preprocessor.getFilename());
+			this->systems.push_back(false);
+			this->marker(1, "");
+		}
+		void put(PPToken token);
+		void flush(); //Writes what is in the buffer
+		void finish(); //Ends the last line and flushes
 	private:
-		BufferedSource<Token>& source;
+		void write(const char* chars, size_t length);
+		void write(const string& str) {this->write(str.data(), str.length());}
+		void changeFiles(); //Follows the files the Preprocessor went through
+		void marker(unsigned int line, const char* flag); //For the last file
+		static const size_t bufferSize = 1 << 20;
+		static const unsigned int maxGap = 8; //Lines filled instead of a marker
+		Preprocessor& preprocessor;
+		int fd;
+		vector<char> buffer;
+		size_t used; //Bytes of the buffer used
+		vector<string> files; //The file written and those including it, last
+		vector<bool> systems; //For each of those, true if a system header
+		unsigned int line; //Line of the file the output is at
+		bool lineStart; //True if nothing has been written on the line
 };
 
 int translate(string filename);
-int phase1(istream *input, ostream *output);
-char trigraph(istream *input);
-int phase2(istream *input, ostream *output);
+int preprocess(string filename, string outputname);
+int precompile(string filename, string outputname);
+int scanDeps(const vector<string>& filenames, bool json, unsigned int jobs, \
+		string outputname);
+void printStats();
 bool isBaseChar(char c);
 string matchComment(Source<char>* source);
 string matchIdentifier(Source<char>* source);
@@ -0,0 +1,99 @@
+#include "translation.h"
+
+TypeContext& TypeContext :: instance() {
+	static TypeContext context;
+	return context;
+}
+
+NoType* TypeContext :: getNoType() {
+	TypeContext& context = instance();
+	++context.lookups;
+	if (context.noType == NULL) {
+		context.noType = new NoType();
+		++context.made;
+	}
+	return context.noType;
+}
+
+BasicType* TypeContext :: getBasicType(BasicTypeEnum basicType) {
+	TypeContext& context = instance();
+	++context.lookups;
+	BasicType*& type = context.basicTypes[basicType];
+	if (type == NULL) {
+		type = new BasicType(basicType);
+		++context.made;
+	}
+	return type;
+}
+
+PointerType* TypeContext :: getPointerType(Type* pointeeType) {
+	TypeContext& context = instance();
+	++context.lookups;
+	PointerType*& type = context.pointerTypes[pointeeType];
+	if (type == NULL) {
+		type = new PointerType(pointeeType);
+		++context.made;
+	}
+	return type;
+}
+
+TypeList* TypeContext :: getTypeList(Type* item, TypeList* next) {
+	TypeContext& context = instance();
+	++context.lookups;
+	TypeList*& list = context.typeLists[make_pair(item, next)];
+	if (list == NULL) {
+		list = new TypeList(item, next);
+		++context.made;
+	}
+	return list;
+}
+
+FunctionType* TypeContext :: getFunctionType(Type* returnType, \
+		TypeList* params) {
+	TypeContext& context = instance();
+	++context.lookups;
+	FunctionType*& type = context.functionTypes[make_pair(returnType, params)];
+	if (type == NULL) {
+		type = new FunctionType(returnType, params);
+		++context.made;
+	}
+	return type;
+}
+
+StructType* TypeContext :: getStructType(TypeList* members) {
+	TypeContext& context = instance();
+	++context.lookups;
+	StructType*& type = context.structTypes[members];
+	if (type == NULL) {
+		type = new StructType(members);
+		++context.made;
+	}
+	return type;
+}
+
+UnionType* TypeContext :: getUnionType(TypeList* members) {
+	TypeContext& context = instance();
+	++context.lookups;
+	UnionType*& type = context.unionTypes[members];
+	if (type == NULL) {
+		type = new UnionType(members);
+		++context.made;
+	}
+	return type;
+}
+
+void TypeContext :: release() {
+	instance().clear();
+}
+
+void TypeContext :: clear() {
+	this->noType = NULL;
+	for (BasicType*& type : this->basicTypes) {
+		type = NULL;
+	}
+	this->pointerTypes.clear();
+	this->typeLists.clear();
+	this->functionTypes.clear();
+	this->structTypes.clear();
+	this->unionTypes.clear();
+}